@@ -27,6 +27,22 @@
 /* USER CODE BEGIN Includes */
 #include "tx_api.h"
 #include "main.h"
+#include "acq.h"
+#include "cond.h"
+#include "cal.h"
+#include "defer.h"
+#include "event.h"
+#include "display.h"
+#include "latency.h"
+#include "modbus.h"
+#include "scope.h"
+#include "spectrum.h"
+#include "stackmon.h"
+#include "stats.h"
+#include "stream.h"
+#include "text.h"
+#include "trace.h"
+#include "usart.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -38,11 +54,66 @@
 /* USER CODE BEGIN PD */
 TX_THREAD               		led_thread;
 TX_THREAD               		printf_thread;
+#if (USE_DISPLAY)
+#define DEMO_STACK_SIZE         256
+#else
 #define DEMO_STACK_SIZE         200
+#endif
+#if (USE_SPECTRUM)
+#define PRINTF_STACK_SIZE       512
+#else
+#define PRINTF_STACK_SIZE       384
+#endif
+/* Where the blocks go while they are streamed */
+#if (USE_COND)
+#define APP_STREAM_BLOCK        COND_Block
+#elif (USE_CAL)
+#define APP_STREAM_BLOCK        CAL_Block
+#else
+#define APP_STREAM_BLOCK        STREAM_Block
+#endif
+#if (USE_EVENT)
+#define APP_EVENT_BLOCK         EVENT_Block
+#else
+#define APP_EVENT_BLOCK         APP_STREAM_BLOCK
+#endif
+/* Statistics see every block, whatever the trigger lets through */
+#if (USE_STATS)
+#define APP_BLOCK               STATS_Block
+#else
+#define APP_BLOCK               APP_EVENT_BLOCK
+#endif
 static uint8_t led_thread_stack[DEMO_STACK_SIZE];
-static uint8_t printf_thread_stack[DEMO_STACK_SIZE];
+static uint8_t printf_thread_stack[PRINTF_STACK_SIZE];
+#if (USE_DISPLAY)
+/* Live readouts in the text band; only the digits that change are redrawn.  */
+static void led_show_status(void)
+{
+    const ACQ_ConfigTypeDef *config = ACQ_GetConfig();
+    uint32_t overruns = acq_overruns;
+
+    TEXT_Print(0, 0, "RATE", TEXT_NORMAL);
+    TEXT_Number(0, 5, (int32_t)(1000000U / config->period_us), 7, TEXT_NORMAL);
+    TEXT_Print(0, 13, "Hz", TEXT_NORMAL);
+    TEXT_Print(1, 0, "RES", TEXT_NORMAL);
+    TEXT_Number(1, 5, config->bits, 2, TEXT_NORMAL);
+    TEXT_Print(1, 8, "b  OS", TEXT_NORMAL);
+    TEXT_Number(1, 14, config->ratio, 3, TEXT_NORMAL);
+    TEXT_Print(2, 0, "OVR", TEXT_NORMAL);
+    TEXT_Number(2, 5, (int32_t)overruns, 7, (overruns != 0U) ? TEXT_ALARM : TEXT_NORMAL);
+#if (USE_LATENCY)
+    TEXT_Print(3, 0, "LAT", TEXT_NORMAL);
+    TEXT_Number(3, 5, (int32_t)LAT_Worst(), 7, TEXT_NORMAL);
+    TEXT_Print(3, 13, "us", TEXT_NORMAL);
+#endif
+}
+#endif
+
 void printf_thread_entry(ULONG thread_input);
 void led_thread_entry(ULONG thread_input);
+#if (USE_DISPLAY)
+static void led_show_status(void);
+#endif
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -68,6 +139,21 @@ void led_thread_entry(ULONG thread_input);
 VOID tx_application_define(VOID *first_unused_memory)
 {
   /* USER CODE BEGIN  tx_application_define */
+#ifdef TX_ENABLE_STACK_CHECKING
+    /* Still on the system stack: fill what is left of it.  */
+    if (STACKMON_Init() != TX_SUCCESS)
+    {
+        Error_Handler();
+    }
+#endif
+#ifdef TX_ENABLE_EVENT_TRACE
+    /* Before the objects are created, so that the registry names them.  */
+    if (TRACE_Init() != TX_SUCCESS)
+    {
+        Error_Handler();
+    }
+#endif
+
     /* Create the led thread.  */
     tx_thread_create(&led_thread,
 					 "led thread",
@@ -86,11 +172,61 @@ VOID tx_application_define(VOID *first_unused_memory)
 					 printf_thread_entry,
 					 0,
 					 printf_thread_stack,
-					 DEMO_STACK_SIZE,
+					 PRINTF_STACK_SIZE,
 					 2,
 					 2,
 					 TX_NO_TIME_SLICE,
 					 TX_AUTO_START);
+
+    /* Interrupts post their work, the printf thread runs it.  */
+    if (USART_Stdout_Init() != TX_SUCCESS || DEFER_Init() != TX_SUCCESS ||
+        STREAM_Init(&uart_tx_stdout) != TX_SUCCESS)
+    {
+        Error_Handler();
+    }
+#if (USE_SPECTRUM)
+    SPECTRUM_Init();
+    if (ACQ_Init(SPECTRUM_Block) != TX_SUCCESS)
+#else
+#if (USE_CAL)
+    CAL_Init();
+#endif
+#if (USE_COND)
+    COND_Init();
+#endif
+#if (USE_EVENT)
+    EVENT_Init(APP_STREAM_BLOCK);
+#endif
+#if (USE_STATS)
+    STATS_Init(APP_EVENT_BLOCK);
+#endif
+    if (ACQ_Init(APP_BLOCK) != TX_SUCCESS)
+#endif
+    {
+        Error_Handler();
+    }
+    if (ACQ_SetOversampling(ACQ_OVERSAMPLING) != HAL_OK || ACQ_Start() != HAL_OK)
+    {
+        Error_Handler();
+    }
+#if (USE_MODBUS)
+    if (MODBUS_Init() != TX_SUCCESS)
+    {
+        Error_Handler();
+    }
+#endif
+#if (USE_DISPLAY)
+    if (DISP_Init(NULL) != TX_SUCCESS || TEXT_Init() != TX_SUCCESS)
+    {
+        Error_Handler();
+    }
+#if (USE_SCOPE)
+    if (SCOPE_Init() != TX_SUCCESS)
+    {
+        Error_Handler();
+    }
+#endif
+#endif
   /* USER CODE END  tx_application_define */
 
   /*
@@ -135,14 +271,21 @@ void led_thread_entry(ULONG thread_input)
     {
 		tx_thread_sleep(200);
       HAL_GPIO_TogglePin(LED_GPIO_Port,LED_Pin);
+#if (USE_DISPLAY)
+      led_show_status();
+#endif
+#ifdef TX_ENABLE_STACK_CHECKING
+      STACKMON_Poll();
+#endif
     }
 }
 
 void printf_thread_entry(ULONG thread_input)
 {
+    /* Run whatever the interrupt handlers have deferred.  */
     while(1)
-    {      
-
+    {
+        DEFER_Dispatch(TX_WAIT_FOREVER);
     }
 }
 
@@ -0,0 +1,109 @@
+/**
+  ******************************************************************************
+  * @file    acq.h
+  * @brief   This file contains all the function prototypes for
+  *          the acq.c file
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __ACQ_H__
+#define __ACQ_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "tx_api.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* Stamp every block for the latency probe, see latency.h. A diagnostic,
+   off by default: costs about 600 bytes of RAM and a stamp in the DMA
+   interrupt. */
+#define USE_LATENCY 0
+
+/* Conversions per frame, in ADC1 fixed-sequence order: IN4, IN5, IN6, VREFINT */
+#define ACQ_CHANNELS     4U
+/* Frames per block, one DMA transfer */
+#define ACQ_BLOCK_FRAMES 16U
+/* Blocks in the pool: one filling, the others queued or held by consumers */
+#define ACQ_POOL_BLOCKS  3U
+/* Queues handed every block besides the output thread, see ACQ_Subscribe */
+#define ACQ_MAX_SUBSCRIBERS 2U
+
+/* Native ADC resolution and the most the 16-bit data register can carry */
+#define ACQ_ADC_BITS     12U
+#define ACQ_MAX_BITS     16U
+/* Largest hardware oversampling ratio */
+#define ACQ_OVS_MAX      256U
+/* Ratio applied at start-up, see ACQ_SetOversampling */
+#ifndef ACQ_OVERSAMPLING
+#define ACQ_OVERSAMPLING 1U
+#endif
+/* TIM1 update period at ratio 1, TIM1 counts at 1 MHz */
+#define ACQ_BASE_PERIOD_US 1000U
+/* ADC clock cycles per conversion, 79.5 sampling + 12.5 successive
+   approximation, and the ADC clock (PCLK / 2) in MHz */
+#define ACQ_CONV_CYCLES  92U
+#define ACQ_ADC_MHZ      32U
+/* VREFINT needs at least 4 us of sampling: 160.5 cycles + 12.5 */
+#define ACQ_VREFINT_CYCLES 173U
+/* ADC clock cycles per frame, the three axes and VREFINT */
+#define ACQ_FRAME_CYCLES ((ACQ_CHANNELS - 1U) * ACQ_CONV_CYCLES + ACQ_VREFINT_CYCLES)
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct {
+    uint16_t x;
+    uint16_t y;
+    uint16_t z;
+    uint16_t vref;
+} ACQ_FrameTypeDef;
+
+/* Sampling set-up the blocks were taken with */
+typedef struct {
+    uint32_t period_us;  /* frame period, stretched when oversampling does not fit */
+    uint16_t ratio;      /* conversions summed per result, 1 when off */
+    uint8_t shift;       /* right shift applied to the sum */
+    uint8_t bits;        /* effective resolution of the results */
+    uint32_t generation; /* bumped on every change */
+} ACQ_ConfigTypeDef;
+
+/* A finished block, shared by reference: valid while its holder has not
+   released it, read-only for everyone */
+typedef struct {
+    const ACQ_FrameTypeDef *frames;  /* ACQ_BLOCK_FRAMES frames */
+    uint32_t seq;                    /* block counter, gaps mean blocks were lost */
+    ULONG stamp;                     /* tick the DMA interrupt fired at */
+    const ACQ_ConfigTypeDef *config; /* sampling set-up, a copy taken with the block */
+    volatile uint32_t refs;          /* holders, back to the pool at zero */
+    uint64_t time;                   /* see ACQ_GetTime */
+#if (USE_LATENCY)
+    uint32_t irq_count;              /* TIM1 count at the DMA interrupt */
+    uint32_t irq_cycles;             /* LP_Cycles at the DMA interrupt */
+#endif
+} ACQ_BlockTypeDef;
+
+/* Runs in the output thread, see defer.h; the block is released after it returns */
+typedef void (*ACQ_CallbackTypeDef)(const ACQ_BlockTypeDef *block);
+
+/* Exported variables --------------------------------------------------------*/
+extern volatile uint32_t acq_overruns;
+
+/* Exported functions prototypes ---------------------------------------------*/
+UINT ACQ_Init(ACQ_CallbackTypeDef callback);
+UINT ACQ_Subscribe(TX_QUEUE *queue);
+void ACQ_Retain(const ACQ_BlockTypeDef *block);
+void ACQ_Release(const ACQ_BlockTypeDef *block);
+HAL_StatusTypeDef ACQ_Start(void);
+HAL_StatusTypeDef ACQ_Stop(void);
+uint8_t ACQ_IsRunning(void);
+HAL_StatusTypeDef ACQ_SetOversampling(uint32_t ratio);
+const ACQ_ConfigTypeDef *ACQ_GetConfig(void);
+uint64_t ACQ_GetTime(const ACQ_BlockTypeDef *block);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ACQ_H__ */
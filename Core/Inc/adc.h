@@ -41,6 +41,7 @@ extern ADC_HandleTypeDef hadc1;
 void MX_ADC1_Init(void);
 
 /* USER CODE BEGIN Prototypes */
+HAL_StatusTypeDef ADC1_DMA_Rearm(uint16_t *buf, uint32_t length);
 
 /* USER CODE END Prototypes */
 
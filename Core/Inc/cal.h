@@ -0,0 +1,66 @@
+/**
+  ******************************************************************************
+  * @file    cal.h
+  * @brief   This file contains all the function prototypes for
+  *          the cal.c file
+  ******************************************************************************
+  * STREAM_TYPE_CAL payload, instead of STREAM_TYPE_SAMPLES, one packet per
+  * acquisition block:
+  *        0     4  stamp     ThreadX tick of the block
+  *        4     4  block     acquisition block counter
+  *        8     8  time      as in STREAM_TYPE_SAMPLES
+  *       16     1  frames    frames in the packet
+  *       17     1  channels  samples per frame (x, y, z)
+  *       18     2  vdda      VDDA in mV, from the block's VREFINT results
+  *       20     .  samples   frames * channels int16, acceleration in mg
+  *
+  * The zero-g offsets and sensitivities below are voltages, for a sensor
+  * whose output does not follow VDDA. A ratiometric sensor supplied from
+  * VDDA already tracks it in raw ADC codes; give it constants taken at the
+  * nominal VDDA and read STREAM_TYPE_SAMPLES instead.
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CAL_H__
+#define __CAL_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "acq.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* Stream calibrated samples in mg instead of raw ADC codes. Costs about
+   150 bytes of RAM. */
+#define USE_CAL 1
+
+/* Zero-g output and sensitivity per axis. Full scale must stay within
+   65535 mg, so at least 56 mV/g. */
+#define CAL_X_ZERO_MV  1650U
+#define CAL_Y_ZERO_MV  1650U
+#define CAL_Z_ZERO_MV  1650U
+#define CAL_X_MV_PER_G 300U
+#define CAL_Y_MV_PER_G 300U
+#define CAL_Z_MV_PER_G 300U
+
+/* VREFINT_CAL expected from the datasheet, used if the factory value is blank:
+   1.212 V at Vref+ = VREFINT_CAL_VREF */
+#define CAL_VREFINT_NOMINAL 1655U
+
+/* Fractional bits of the per-block gains */
+#define CAL_GAIN_BITS   16U
+#define CAL_HEADER_SIZE 20U
+
+/* Exported functions prototypes ---------------------------------------------*/
+void CAL_Init(void);
+void CAL_Block(const ACQ_BlockTypeDef *block);
+uint32_t CAL_GetVdda(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAL_H__ */
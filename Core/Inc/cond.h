@@ -0,0 +1,76 @@
+/**
+  ******************************************************************************
+  * @file    cond.h
+  * @brief   This file contains all the function prototypes for
+  *          the cond.c file
+  ******************************************************************************
+  * STREAM_TYPE_COND payload, instead of STREAM_TYPE_CAL or
+  * STREAM_TYPE_SAMPLES while a preset other than COND_PRESET_OFF is
+  * selected:
+  *        0     4  stamp     ThreadX tick of the first block
+  *        4     4  block     acquisition block counter of the first block
+  *        8     8  time      as in STREAM_TYPE_SAMPLES, of the first block
+  *       16     1  frames    frames in the packet
+  *       17     1  decimation  input frames per output frame, M
+  *       18     .  samples   frames * STREAM_CHANNELS int16, x, y, z;
+  *                           q15, 1.0 is half the ADC range
+  *
+  * Output frame i of a packet is taken at input frame i * M of its first
+  * block; the filters delay it further by their group delay. Sampling
+  * set-up as in the last STREAM_TYPE_META, fs_out = fs / M.
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __COND_H__
+#define __COND_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "acq.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* Condition the samples before they are streamed. Off by default: costs
+   about 900 bytes of RAM, which the 8 KB part cannot spare next to the
+   other default modules, and the CMSIS-DSP biquad and FIR decimator. */
+#define USE_COND 0
+
+/* Presets, coefficient sets of cond.c; fc is the low-pass -3 dB point */
+#define COND_PRESET_OFF   0U  /* STREAM_TYPE_CAL or STREAM_TYPE_SAMPLES */
+#define COND_PRESET_LP    1U  /* fc = fs / 8, no decimation */
+#define COND_PRESET_DEC4  2U  /* fc = 0.35 fs / 4, M = 4 */
+#define COND_PRESET_DEC8  3U  /* fc = 0.35 fs / 8, M = 8 */
+#define COND_PRESET_DEC16 4U  /* fc = 0.35 fs / 16, M = 16 */
+#define COND_PRESETS      5U
+#define COND_PRESET       COND_PRESET_OFF
+
+/* DC removal: the DC estimate follows the input with a time constant of
+   2^shift frames; 0 subtracts mid-scale instead */
+#define COND_DC_SHIFT     10U
+#define COND_DC_SHIFT_MAX 15U
+
+/* Second order sections of the low-pass, and taps of the longest decimator */
+#define COND_STAGES       2U
+#define COND_MAX_TAPS     32U
+
+/* Output frames per packet */
+#define COND_BATCH_FRAMES 32U
+#define COND_HEADER_SIZE  18U
+
+/* Exported functions prototypes ---------------------------------------------*/
+void COND_Init(void);
+void COND_Block(const ACQ_BlockTypeDef *block);
+HAL_StatusTypeDef COND_SetPreset(uint32_t preset);
+uint32_t COND_GetPreset(void);
+HAL_StatusTypeDef COND_SetDcShift(uint32_t shift);
+uint32_t COND_GetDcShift(void);
+uint32_t COND_GetDecimation(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __COND_H__ */
@@ -0,0 +1,47 @@
+/**
+  ******************************************************************************
+  * @file    defer.h
+  * @brief   This file contains all the function prototypes for
+  *          the defer.c file
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __DEFER_H__
+#define __DEFER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "tx_api.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* Work items that may wait for the output thread */
+#define DEFER_QUEUE_DEPTH 8U
+
+/* Exported types ------------------------------------------------------------*/
+/* Runs in the output thread; stamp is the tick the item was posted at */
+typedef void (*DEFER_FuncTypeDef)(ULONG arg, ULONG stamp);
+
+typedef struct {
+    DEFER_FuncTypeDef func;
+    ULONG arg;
+    ULONG stamp; /* tx_time_get() when posted */
+    ULONG seq;   /* post counter, gaps mean items were dropped */
+} DEFER_WorkTypeDef;
+
+/* Exported variables --------------------------------------------------------*/
+extern volatile uint32_t defer_dropped;
+
+/* Exported functions prototypes ---------------------------------------------*/
+UINT DEFER_Init(void);
+UINT DEFER_Post(DEFER_FuncTypeDef func, ULONG arg);
+UINT DEFER_Dispatch(ULONG wait_option);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DEFER_H__ */
@@ -0,0 +1,87 @@
+/**
+  ******************************************************************************
+  * @file    display.h
+  * @brief   This file contains all the function prototypes for
+  *          the display.c file
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __DISPLAY_H__
+#define __DISPLAY_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "tx_api.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* ST7735 TFT on SPI1, LCD_RS data/command and LCD_RES reset. Off by
+   default: the display costs about 1.3 KB of RAM, more with the text cache
+   and the scope, which the 8 KB part cannot spare next to the other
+   default modules. */
+#define USE_DISPLAY 0
+
+/* Panel size in the MADCTL orientation below; offsets of the visible area
+   in controller RAM, non-zero on some 1.8" and 0.96" modules */
+#define DISP_WIDTH     128U
+#define DISP_HEIGHT    160U
+#define DISP_X_OFFSET  0U
+#define DISP_Y_OFFSET  0U
+/* MY and MX, as the DFP st7735 component sets it */
+#define DISP_MADCTL    0xC0U
+
+/* Lines per tile; two tiles, 512 bytes of single lines, are the whole
+   frame buffer */
+#define DISP_TILE_LINES 1U
+#define DISP_TILE_PIXELS (DISP_WIDTH * DISP_TILE_LINES)
+
+/* Modules redrawing part of the panel between frames, see DISP_AddUpdate:
+   the text band and the scope */
+#define DISP_MAX_UPDATES 2U
+
+#define DISP_STACK_SIZE 384U
+/* Below every other thread but the trace drain */
+#define DISP_PRIORITY   (TX_MAX_PRIORITIES - 2U)
+/* Frame rate governor: passes, whole frames or only updates, start at
+   least DISP_FRAME_TICKS apart, 25 a second for the scope, and a pass that
+   took t ticks is followed by at least (DISP_DUTY - 1) * t ticks of rest,
+   so the display gets 1 / DISP_DUTY of the time at most */
+#define DISP_FRAME_TICKS 40U
+#define DISP_DUTY        4U
+/* Polled command writes, ms */
+#define DISP_TIMEOUT     10U
+
+/* RGB565 */
+#define DISP_RGB(r, g, b) ((uint16_t)((((r) & 0xF8U) << 8) | (((g) & 0xFCU) << 3) | ((b) >> 3)))
+#define DISP_BLACK        0x0000U
+#define DISP_WHITE        0xFFFFU
+
+/* Exported types ------------------------------------------------------------*/
+/* Fill lines y to y + lines - 1 of the frame, DISP_WIDTH pixels each, row by
+   row; runs in the display thread while the previous tile is being sent */
+typedef void (*DISP_RenderTypeDef)(uint16_t *pixels, uint16_t y, uint16_t lines);
+/* Redraw with DISP_Blit what changed since the last call, everything the
+   module owns when full is set: a whole frame has just been drawn over it */
+typedef void (*DISP_UpdateTypeDef)(uint8_t full);
+
+/* Exported variables --------------------------------------------------------*/
+extern volatile uint32_t disp_frames;
+
+/* Exported functions prototypes ---------------------------------------------*/
+UINT DISP_Init(DISP_RenderTypeDef render);
+UINT DISP_AddUpdate(DISP_UpdateTypeDef update);
+void DISP_Invalidate(void);
+void DISP_Update(void);
+void DISP_Blit(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *pixels);
+uint16_t *DISP_Line(void);
+void DISP_ScrollArea(uint16_t top, uint16_t lines);
+void DISP_ScrollTo(uint16_t y);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DISPLAY_H__ */
@@ -0,0 +1,92 @@
+/**
+  ******************************************************************************
+  * @file    event.h
+  * @brief   This file contains all the function prototypes for
+  *          the event.c file
+  ******************************************************************************
+  * STREAM_TYPE_EVENT payload, the only sample packets while a trigger mode
+  * is selected; an event is sent as consecutive records, the last one
+  * flagged:
+  *        0     4  stamp     ThreadX tick of the trigger block
+  *        4     4  block     acquisition block counter of the trigger block
+  *        8     8  time      as in STREAM_TYPE_SAMPLES, of the trigger
+  *                           block: the trigger frame was taken at
+  *                           time + frame * period
+  *       16     1  frame     trigger frame within that block
+  *       17     1  axes      axes over their level at the trigger, bit 0 x
+  *       18     2  event     event counter
+  *       20     2  offset    first frame of the record relative to the
+  *                           trigger frame, int16, negative before it
+  *       22     1  frames    frames in the record
+  *       23     1  flags     EVENT_FLAG_xxx
+  *       24     .  samples   frames * STREAM_CHANNELS raw ADC results,
+  *                           uint16, resolution as in the last
+  *                           STREAM_TYPE_META
+  *
+  * A STREAM_TYPE_META packet precedes the first record whenever the host
+  * may not have seen the sampling set-up yet.
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __EVENT_H__
+#define __EVENT_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "acq.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* Event capture: send only a window around each trigger instead of every
+   sample. Costs about 350 bytes of RAM. */
+#define USE_EVENT 1
+
+/* Trigger modes */
+#define EVENT_MODE_OFF   0U  /* stream every block, no capture */
+#define EVENT_MODE_LEVEL 1U  /* a sample strays level codes from the axis baseline */
+#define EVENT_MODE_SLOPE 2U  /* two successive samples differ by level codes */
+#define EVENT_MODES      3U
+#define EVENT_MODE       EVENT_MODE_OFF
+
+/* Per-axis level in ADC codes at the resolution in use, 0 disarms the axis */
+#define EVENT_LEVEL      200U
+
+/* Frames kept from before the trigger, a power of two, and sent after it,
+   the trigger frame included */
+#define EVENT_PRE_MAX    32U
+#define EVENT_PRE        16U
+#define EVENT_POST_MAX   4096U
+#define EVENT_POST       48U
+
+/* The level baseline follows the block means with a time constant of
+   2^EVENT_BASE_SHIFT blocks */
+#define EVENT_BASE_SHIFT 4U
+
+/* Record flags */
+#define EVENT_FLAG_LAST      0x01U  /* last record of the event */
+#define EVENT_FLAG_TRUNCATED 0x02U  /* ended early: lost blocks, new set-up or mode */
+
+#define EVENT_RECORD_FRAMES ACQ_BLOCK_FRAMES
+#define EVENT_HEADER_SIZE   24U
+
+/* Exported functions prototypes ---------------------------------------------*/
+void EVENT_Init(ACQ_CallbackTypeDef stream);
+void EVENT_Block(const ACQ_BlockTypeDef *block);
+HAL_StatusTypeDef EVENT_SetMode(uint32_t mode);
+uint32_t EVENT_GetMode(void);
+HAL_StatusTypeDef EVENT_SetLevel(uint32_t axis, uint32_t level);
+uint32_t EVENT_GetLevel(uint32_t axis);
+HAL_StatusTypeDef EVENT_SetPre(uint32_t pre);
+uint32_t EVENT_GetPre(void);
+HAL_StatusTypeDef EVENT_SetPost(uint32_t post);
+uint32_t EVENT_GetPost(void);
+uint32_t EVENT_GetCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __EVENT_H__ */
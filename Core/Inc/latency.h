@@ -0,0 +1,74 @@
+/**
+  ******************************************************************************
+  * @file    latency.h
+  * @brief   This file contains all the function prototypes for
+  *          the latency.c file
+  ******************************************************************************
+  * STREAM_TYPE_LATENCY payload, one packet per stage, sent by LAT_Report:
+  *        0     4  stamp     ThreadX tick of the report
+  *        4     1  stage     LAT_STAGE_IRQ, LAT_STAGE_THREAD or LAT_STAGE_TOTAL
+  *        5     1  bins      histogram bins that follow
+  *        6     2  reserved
+  *        8     4  count     blocks measured since the last clear
+  *       12     4  min       us
+  *       16     4  mean      us
+  *       20     4  max       us
+  *       24    16  p50, p90, p99, p99.9
+  *                           us, upper bound of the bin the percentile
+  *                           falls in, never above max
+  *       40     4  period    frame period the blocks were taken at, us
+  *       44     4  conv      conversion time of a frame, us
+  *       48  2*n  counts     per bin, halved together when one would overflow
+  *
+  * Bin i covers i us below LAT_LINEAR_BINS, then every octave from 8 us
+  * up is split into LAT_OCTAVE_BINS equal bins; the last bin also holds
+  * everything above it.
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LATENCY_H__
+#define __LATENCY_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "acq.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define LAT_STAGE_IRQ     0U  /* TIM1 trigger to the DMA interrupt */
+#define LAT_STAGE_THREAD  1U  /* DMA interrupt to the output thread */
+#define LAT_STAGE_TOTAL   2U  /* trigger to the output thread */
+#define LAT_STAGES        3U
+
+#define LAT_LINEAR_BINS   8U
+#define LAT_OCTAVE_BINS   4U
+/* Octaves from 8 us, the last bin ends at 65535 us */
+#define LAT_OCTAVES       13U
+#define LAT_BINS          (LAT_LINEAR_BINS + LAT_OCTAVES * LAT_OCTAVE_BINS)
+#define LAT_HEADER_SIZE   48U
+#define LAT_PAYLOAD_SIZE  (LAT_HEADER_SIZE + 2U * LAT_BINS)
+
+/* Exported macro ------------------------------------------------------------*/
+/* First thing in the DMA1 channel 1 handler */
+#if (USE_LATENCY)
+#define LAT_ISR_ENTER() LAT_IsrEnter()
+#else
+#define LAT_ISR_ENTER()
+#endif
+
+/* Exported functions prototypes ---------------------------------------------*/
+void LAT_Init(void);
+void LAT_IsrEnter(void);
+void LAT_Stamp(ACQ_BlockTypeDef *block);
+void LAT_Record(const ACQ_BlockTypeDef *block);
+void LAT_Report(uint8_t clear);
+uint32_t LAT_Worst(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LATENCY_H__ */
@@ -0,0 +1,48 @@
+/**
+  ******************************************************************************
+  * @file    lowpower.h
+  * @brief   This file contains all the function prototypes for
+  *          the lowpower.c file
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LOWPOWER_H__
+#define __LOWPOWER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "tx_api.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* LPTIM1 count rate, LSE / 32 */
+#define LP_LPTIM_HZ    1024U
+/* Shorter idle periods keep SysTick running and only WFI */
+#define LP_MIN_TICKS   2U
+/* Longest tickless period, keeps the wake-up arithmetic in 32 bits */
+#define LP_MAX_TICKS   4000U
+/* LP_Cycles rate, the core clock */
+#define LP_CYCLES_PER_US 64U
+
+/* Exported variables --------------------------------------------------------*/
+extern volatile uint32_t lp_stop_entries;
+extern volatile uint32_t lp_sleep_entries;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void LP_Init(void);
+void LP_Hold(void);
+void LP_Release(void);
+uint32_t LP_Cycles(void);
+
+/* Called by the port scheduler around WFI when TX_LOW_POWER is defined */
+void tx_low_power_enter(void);
+void tx_low_power_exit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LOWPOWER_H__ */
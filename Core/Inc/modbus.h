@@ -0,0 +1,167 @@
+/**
+  ******************************************************************************
+  * @file    modbus.h
+  * @brief   This file contains all the function prototypes for
+  *          the modbus.c file
+  ******************************************************************************
+  * Modbus RTU slave on USART2, functions 03, 04, 06 and 16. 32-bit values
+  * take two registers, high word first.
+  *
+  * Holding registers:
+  *        0  oversampling  1, 2, 4 ... 256, see ACQ_SetOversampling
+  *        1  run           1 acquiring, write 0 to stop and 1 to start
+  *        2  profile       with TX_EXECUTION_PROFILE_ENABLE, reads 0; write 1
+  *                         to send a STREAM_TYPE_PROFILE packet on stdout
+  *                         and start a new window, see prof.h
+  *        3  stacks        with TX_ENABLE_STACK_CHECKING, reads 0; write 1
+  *                         to send the STREAM_TYPE_STACK packets, see
+  *                         stackmon.h
+  *        4  latency       with USE_LATENCY, reads 0; write 1 to send the
+  *                         STREAM_TYPE_LATENCY packets, 2 to send them and
+  *                         clear the histograms, see latency.h
+  *        5  cond_preset   with USE_COND, COND_PRESET_xxx: 0 streams
+  *                         calibrated or raw samples, 1 low-pass, 2 to
+  *                         4 low-pass and decimate by 4, 8 or 16, see
+  *                         cond.h
+  *        6  cond_dc       with USE_COND, DC removal time constant, 2^n
+  *                         frames, 1 to 15; 0 subtracts mid-scale
+  *        7  event_mode    with USE_EVENT, EVENT_MODE_xxx: 0 streams
+  *                         every block, 1 level or 2 slope trigger sends
+  *                         only the window around each event, see event.h
+  *     8-10  event_level   with USE_EVENT, x, y and z trigger level in ADC
+  *                         codes, 0 disarms the axis
+  *       11  event_pre     with USE_EVENT, frames sent before the trigger,
+  *                         up to EVENT_PRE_MAX
+  *       12  event_post    with USE_EVENT, frames sent from the trigger on,
+  *                         1 to EVENT_POST_MAX
+  *       13  stats_mode    with USE_STATS, STATS_MODE_xxx: 0 off, 1 a
+  *                         statistics record per window besides the
+  *                         samples, 2 the records only, see stats.h
+  *       14  stats_window  with USE_STATS, window length in ms,
+  *                         STATS_WINDOW_MIN_MS to STATS_WINDOW_MAX_MS
+  *       15  format        STREAM_FORMAT_xxx: 0 16-bit samples, 1 raw
+  *                         samples packed to their resolution, see
+  *                         stream.h, 2 with USE_RICE raw samples
+  *                         compressed without loss, see rice.h
+  *       16  axes          axes packed or compressed samples carry,
+  *                         bit 0 x, 1 to 7
+  *
+  * Input registers:
+  *      0-1  period_us     frame period
+  *        2  rate          frames per second
+  *        3  ratio         oversampling ratio in use
+  *        4  bits          effective resolution
+  *      5-6  overruns      acq_overruns
+  *      7-8  dropped       defer_dropped
+  *     9-10  ticks         tx_time_get()
+  *       11  frames        requests addressed to this slave
+  *       12  crc_errors    frames discarded on a bad CRC or length
+  *       13  lost          frames the Modbus thread had no room for
+  *       14  overflows     stack overflows seen, stackmon_overflows
+  *       15  trace_lost    trace entries overwritten before they were sent
+  *       16  latency_max   longest trigger-to-thread latency since the
+  *                         last clear, us, 65535 at most
+  *       17  cond_rate     with USE_COND, streamed frames per second
+  *       18  vdda          with USE_CAL, VDDA in mV from VREFINT, see cal.h
+  *       19  events        with USE_EVENT, events triggered, low 16 bits
+  *   0x100+  peaks         with USE_SPECTRUM, for x, y then z and each of
+  *                         the SPECTRUM_PEAKS peaks: bin, magnitude
+  *   0x200+  stats         with USE_STATS, the last window for x, y then
+  *                         z, 8 registers each: mean in ADC codes, rms
+  *                         in codes Q4, peak, peak-to-peak, crest factor
+  *                         Q8, kurtosis Q8, min, max
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __MODBUS_H__
+#define __MODBUS_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "usart.h"
+#include "tx_api.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* Slave address, 1 to 247; 0 is broadcast */
+#define MODBUS_ADDRESS     1U
+#define MODBUS_BROADCAST   0U
+
+/* Silence that ends a frame, in bit times: 3.5 characters of 10 bits;
+   the idle line flags the first character of it */
+#define MODBUS_T35_BITS    35U
+#define MODBUS_IDLE_BITS   10U
+
+/* Largest frame, and the receive DMA ring: one frame and the start of
+   the next */
+#define MODBUS_ADU_SIZE    256U
+#define MODBUS_RX_SIZE     (MODBUS_ADU_SIZE + 32U)
+/* Ticks an answer may take on the wire, 256 bytes need 6 ms */
+#define MODBUS_TX_TIMEOUT  20U
+/* Frames waiting for the Modbus thread */
+#define MODBUS_QUEUE_DEPTH 4U
+
+#define MODBUS_STACK_SIZE  384U
+#define MODBUS_PRIORITY    1U
+
+/* Holding registers */
+#define MODBUS_HR_OVERSAMPLING 0x0000U
+#define MODBUS_HR_RUN          0x0001U
+#define MODBUS_HR_PROFILE      0x0002U
+#define MODBUS_HR_STACKS       0x0003U
+#define MODBUS_HR_LATENCY      0x0004U
+#define MODBUS_HR_COND_PRESET  0x0005U
+#define MODBUS_HR_COND_DC      0x0006U
+#define MODBUS_HR_EVENT_MODE   0x0007U
+#define MODBUS_HR_EVENT_LEVEL  0x0008U
+#define MODBUS_HR_EVENT_PRE    0x000BU
+#define MODBUS_HR_EVENT_POST   0x000CU
+#define MODBUS_HR_STATS_MODE   0x000DU
+#define MODBUS_HR_STATS_WINDOW 0x000EU
+#define MODBUS_HR_FORMAT       0x000FU
+#define MODBUS_HR_AXES         0x0010U
+
+/* Input registers */
+#define MODBUS_IR_PERIOD_HI    0x0000U
+#define MODBUS_IR_PERIOD_LO    0x0001U
+#define MODBUS_IR_RATE         0x0002U
+#define MODBUS_IR_RATIO        0x0003U
+#define MODBUS_IR_BITS         0x0004U
+#define MODBUS_IR_OVERRUNS_HI  0x0005U
+#define MODBUS_IR_OVERRUNS_LO  0x0006U
+#define MODBUS_IR_DROPPED_HI   0x0007U
+#define MODBUS_IR_DROPPED_LO   0x0008U
+#define MODBUS_IR_TICKS_HI     0x0009U
+#define MODBUS_IR_TICKS_LO     0x000AU
+#define MODBUS_IR_FRAMES       0x000BU
+#define MODBUS_IR_CRC_ERRORS   0x000CU
+#define MODBUS_IR_LOST         0x000DU
+#define MODBUS_IR_OVERFLOWS    0x000EU
+#define MODBUS_IR_TRACE_LOST   0x000FU
+#define MODBUS_IR_LATENCY_MAX  0x0010U
+#define MODBUS_IR_COND_RATE    0x0011U
+#define MODBUS_IR_VDDA         0x0012U
+#define MODBUS_IR_EVENTS       0x0013U
+#define MODBUS_IR_PEAKS        0x0100U
+#define MODBUS_IR_STATS        0x0200U
+#define MODBUS_IR_STATS_AXIS   8U
+
+/* Exported variables --------------------------------------------------------*/
+extern volatile uint32_t modbus_frames;
+extern volatile uint32_t modbus_crc_errors;
+extern volatile uint32_t modbus_lost;
+
+/* Exported functions prototypes ---------------------------------------------*/
+UINT MODBUS_Init(void);
+void MODBUS_UART_IRQHandler(UART_HandleTypeDef *huart);
+void MODBUS_TIM_IRQHandler(TIM_HandleTypeDef *htim);
+void MODBUS_ErrorCallback(UART_HandleTypeDef *huart);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MODBUS_H__ */
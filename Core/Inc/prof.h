@@ -0,0 +1,68 @@
+/**
+  ******************************************************************************
+  * @file    prof.h
+  * @brief   This file contains all the function prototypes for
+  *          the prof.c file
+  ******************************************************************************
+  * STREAM_TYPE_PROFILE payload, sent by PROF_Report, times over the window
+  * since the previous report:
+  *        0     4  stamp     ThreadX tick the window ended at
+  *        4     4  window    window length in us
+  *        8     4  isr       us in interrupt handlers
+  *       12     4  irqs      interrupts taken, nested ones not counted
+  *       16     4  idle      us with no thread running, scheduler included
+  *       20     1  threads   records that follow, one per thread seen
+  *       21    24  record    per thread:
+  *                             0  4  run      us the thread ran
+  *                             4  4  resumes  times it was switched in
+  *                             8 16  name     thread name, NUL padded
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __PROF_H__
+#define __PROF_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "tx_api.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* TIM3 count rate, PCLK / 2, see MX_TIM3_Init */
+#define PROF_CLOCK_HZ     32000000U
+/* Threads tracked; time of any further thread counts as idle */
+#define PROF_MAX_THREADS  6U
+#define PROF_NAME_SIZE    16U
+#define PROF_HEADER_SIZE  21U
+#define PROF_RECORD_SIZE  (8U + PROF_NAME_SIZE)
+
+/* Exported macro ------------------------------------------------------------*/
+/* Bracket every interrupt handler body; SysTick is bracketed by the port */
+#ifdef TX_EXECUTION_PROFILE_ENABLE
+#define PROF_ISR_ENTER() _tx_execution_isr_enter()
+#define PROF_ISR_EXIT()  _tx_execution_isr_exit()
+#else
+#define PROF_ISR_ENTER()
+#define PROF_ISR_EXIT()
+#endif
+
+/* Exported functions prototypes ---------------------------------------------*/
+void PROF_Init(void);
+void PROF_Report(void);
+
+/* ThreadX execution profile hooks, called by the port when
+   TX_EXECUTION_PROFILE_ENABLE is defined */
+VOID _tx_execution_initialize(VOID);
+VOID _tx_execution_thread_enter(VOID);
+VOID _tx_execution_thread_exit(VOID);
+VOID _tx_execution_isr_enter(VOID);
+VOID _tx_execution_isr_exit(VOID);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PROF_H__ */
@@ -0,0 +1,76 @@
+/**
+  ******************************************************************************
+  * @file    rice.h
+  * @brief   This file contains all the function prototypes for
+  *          the rice.c file
+  ******************************************************************************
+  * STREAM_TYPE_RICE payload, instead of STREAM_TYPE_SAMPLES with
+  * STREAM_FORMAT_RICE:
+  *        0     4  stamp     ThreadX tick of the first block
+  *        4     4  block     acquisition block counter of the first block
+  *        8     8  time      as in STREAM_TYPE_SAMPLES
+  *       16     1  frames    frames in the packet
+  *       17     1  axes      axes sent, bit 0 x, bit 1 y, bit 2 z
+  *       18     1  width     bits per raw sample, the resolution in use
+  *       19     1  channels  axes sent
+  *       20     2  sum1      Fletcher sums of the samples, mod 2^16, in
+  *       22     2  sum2      the order they are coded
+  *       24     .  blocks    one per acquisition block, each starting on
+  *                           a byte boundary
+  *
+  * A block holds a subframe per axis sent, x first, in a little-endian bit
+  * stream (bit 0 of a field first):
+  *        2 bits  order      0 verbatim: ACQ_BLOCK_FRAMES samples of width
+  *                           bits follow; 1 to 3 fixed predictor order
+  *        5 bits  k          Rice parameter, only with order 1 to 3
+  *        then per frame, a sample of width bits while fewer than order
+  *        samples of the axis precede it in the packet, else the residual
+  *        e = x - p, zigzagged to u = 2e or -2e - 1, as u >> k one bits,
+  *        a zero bit and the k low bits of u. The predictions, from the
+  *        previous samples x1, x2, x3 of the axis, also those of the
+  *        previous block of the packet:
+  *          order 1  p = x1
+  *          order 2  p = 2 x1 - x2
+  *          order 3  p = 3 x1 - 3 x2 + x3
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __RICE_H__
+#define __RICE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "acq.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* Lossless predictive Rice coding of raw samples. Costs about 50 bytes of
+   RAM. */
+#define USE_RICE 1
+
+#define RICE_ORDER_MAX    3U
+#define RICE_K_BITS       5U
+#define RICE_K_MAX        20U
+#define RICE_AXES         3U
+#define RICE_HEADER_SIZE  24U
+/* Blocks per packet at most; a packet also closes when the next block
+   might not fit */
+#define RICE_BATCH_BLOCKS 4U
+
+/* Largest block: a verbatim subframe per axis */
+#define RICE_BLOCK_MAX(channels, width) \
+    (((channels) * (2U + ACQ_BLOCK_FRAMES * (width)) + 7U) / 8U)
+
+/* Exported functions prototypes ---------------------------------------------*/
+void RICE_Start(void);
+uint8_t *RICE_Block(uint8_t *out, const ACQ_BlockTypeDef *block, uint32_t axes, uint32_t width);
+uint32_t RICE_GetCheck(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RICE_H__ */
@@ -0,0 +1,61 @@
+/**
+  ******************************************************************************
+  * @file    scope.h
+  * @brief   This file contains all the function prototypes for
+  *          the scope.c file
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SCOPE_H__
+#define __SCOPE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "tx_api.h"
+#include "acq.h"
+#include "display.h"
+#include "text.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* Scrolling x, y and z trace below the text band, with USE_DISPLAY. Off
+   by default: costs about 600 bytes of RAM on top of the display. */
+#define USE_SCOPE 0
+
+#define SCOPE_TOP        TEXT_HEIGHT
+#define SCOPE_LINES      (DISP_HEIGHT - SCOPE_TOP)
+/* Samples run across the panel, DISP_WIDTH = 1 << SCOPE_WIDTH_BITS */
+#define SCOPE_WIDTH_BITS 7U
+
+/* Acquisition blocks averaged into one line of trace; a block is
+   ACQ_BLOCK_FRAMES frames */
+#define SCOPE_DECIMATION 1U
+/* Lines waiting for the display thread; more are dropped */
+#define SCOPE_RING       16U
+
+#define SCOPE_STACK_SIZE 256U
+/* Right below the output thread: it only averages and lets go of blocks */
+#define SCOPE_PRIORITY   3U
+/* Blocks waiting to be averaged, each one held from the acquisition pool */
+#define SCOPE_QUEUE_DEPTH 2U
+
+/* Trace colours */
+#define SCOPE_X_COLOUR   DISP_RGB(255, 64, 64)
+#define SCOPE_Y_COLOUR   DISP_RGB(64, 255, 64)
+#define SCOPE_Z_COLOUR   DISP_RGB(64, 160, 255)
+#define SCOPE_MID_COLOUR DISP_RGB(64, 64, 64)
+
+/* Exported variables --------------------------------------------------------*/
+extern volatile uint32_t scope_dropped;
+
+/* Exported functions prototypes ---------------------------------------------*/
+UINT SCOPE_Init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SCOPE_H__ */
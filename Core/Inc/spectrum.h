@@ -0,0 +1,56 @@
+/**
+  ******************************************************************************
+  * @file    spectrum.h
+  * @brief   This file contains all the function prototypes for
+  *          the spectrum.c file
+  ******************************************************************************
+  * Spectrum packets share an 11-byte header, multi-byte fields little-endian:
+  *        0     4  stamp     ThreadX tick of the first block of the window
+  *        4     4  block     acquisition block counter of that block
+  *        8     2  fft_len   SPECTRUM_FFT_LEN, bin k is k * fs / fft_len Hz
+  *       10     1  count     entries that follow
+  *
+  * STREAM_TYPE_PEAKS: for x, y then z, count entries of
+  *                    { uint8 bin, uint16 magnitude }, largest first.
+  * STREAM_TYPE_BINS:  uint8 axis, uint8 first bin, then count uint16
+  *                    magnitudes; each axis takes two packets.
+  *
+  * Magnitudes are arm_cmplx_mag_q15 output of the scaled arm_rfft_q15
+  * result: raw codes, relative units.
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SPECTRUM_H__
+#define __SPECTRUM_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "acq.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* Stream spectra instead of raw samples. Costs about 2.5 KB of RAM. */
+#define USE_SPECTRUM 0
+
+/* x, y and z */
+#define SPECTRUM_AXES      3U
+/* Real FFT length, a whole number of acquisition blocks */
+#define SPECTRUM_FFT_LEN   256U
+/* Largest bins reported per axis, 0 streams every bin */
+#define SPECTRUM_PEAKS     8U
+
+#define SPECTRUM_HEADER_SIZE 11U
+
+/* Exported functions prototypes ---------------------------------------------*/
+void SPECTRUM_Init(void);
+void SPECTRUM_Block(const ACQ_BlockTypeDef *block);
+uint8_t SPECTRUM_GetPeak(uint32_t axis, uint32_t rank, uint16_t *mag);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SPECTRUM_H__ */
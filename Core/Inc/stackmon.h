@@ -0,0 +1,51 @@
+/**
+  ******************************************************************************
+  * @file    stackmon.h
+  * @brief   This file contains all the function prototypes for
+  *          the stackmon.c file
+  ******************************************************************************
+  * STREAM_TYPE_STACK payload, one packet per stack, sent by STACKMON_Report:
+  *        0     4  stamp     ThreadX tick of the report
+  *        4     1  index     0 for the system (MSP) stack, threads from 1
+  *        5     1  count     stacks in this report
+  *        6     2  size      stack size in bytes
+  *        8     2  peak      most bytes ever in use, from the fill pattern
+  *       10     1  overflow  1 once the stack has been seen overflowing
+  *       11     1  reserved
+  *       12    16  name      thread name, NUL padded
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __STACKMON_H__
+#define __STACKMON_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "tx_api.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* ThreadX fills thread stacks with this word, TX_STACK_FILL */
+#define STACKMON_FILL       0xEFEFEFEFUL
+/* Bytes of the system stack left unfilled below the caller of STACKMON_Init */
+#define STACKMON_SYS_GUARD  32U
+#define STACKMON_NAME_SIZE  16U
+#define STACKMON_RECORD_SIZE (12U + STACKMON_NAME_SIZE)
+
+/* Exported variables --------------------------------------------------------*/
+extern volatile uint32_t stackmon_overflows;
+
+/* Exported functions prototypes ---------------------------------------------*/
+UINT STACKMON_Init(void);
+void STACKMON_Poll(void);
+void STACKMON_Report(void);
+uint32_t STACKMON_Peak(const TX_THREAD *thread);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STACKMON_H__ */
@@ -0,0 +1,86 @@
+/**
+  ******************************************************************************
+  * @file    stats.h
+  * @brief   This file contains all the function prototypes for
+  *          the stats.c file
+  ******************************************************************************
+  * STREAM_TYPE_STATS payload, one per window:
+  *        0     4  stamp     ThreadX tick of the last block of the window
+  *        4     4  block     acquisition block counter of the first block
+  *        8     4  period    frame period in us
+  *       12     2  frames    frames in the window, lost blocks left out
+  *       14     1  bits      effective resolution of the samples
+  *       15     1  axes      STATS_AXES
+  *       16    18  x, then y and z:
+  *                   0  4  mean      ADC codes, Q8
+  *                   4  4  rms       ADC codes, Q8, about the mean
+  *                   8  2  min       ADC code
+  *                  10  2  max       ADC code
+  *                  12  2  peak      largest distance from the mean, codes
+  *                  14  2  crest     peak / rms, Q8
+  *                  16  2  kurtosis  Q8, 3.0 for Gaussian noise
+  *
+  * Peak-to-peak is max - min.
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __STATS_H__
+#define __STATS_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "acq.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* Vibration statistics per window. Costs about 250 bytes of RAM. */
+#define USE_STATS 1
+
+/* Modes */
+#define STATS_MODE_OFF    0U  /* no statistics */
+#define STATS_MODE_ON     1U  /* a record per window besides the samples */
+#define STATS_MODE_ONLY   2U  /* records only, the blocks go no further */
+#define STATS_MODES       3U
+#define STATS_MODE        STATS_MODE_ON
+
+/* Window length; at most 10 s keeps the sum of x^4 within 64 bits */
+#define STATS_WINDOW_MS     1000U
+#define STATS_WINDOW_MIN_MS 100U
+#define STATS_WINDOW_MAX_MS 10000U
+
+/* Resolution the moments are taken at, whatever the oversampling */
+#define STATS_MOMENT_BITS 12U
+
+#define STATS_AXES        3U
+#define STATS_HEADER_SIZE 16U
+#define STATS_AXIS_SIZE   18U
+
+/* Exported types ------------------------------------------------------------*/
+/* Summary of one axis over the last window */
+typedef struct {
+    uint32_t mean;      /* codes, Q8 */
+    uint32_t rms;       /* codes, Q8, about the mean */
+    uint16_t min;
+    uint16_t max;
+    uint16_t peak;      /* codes from the mean */
+    uint16_t crest;     /* Q8 */
+    uint16_t kurtosis;  /* Q8 */
+} STATS_AxisTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void STATS_Init(ACQ_CallbackTypeDef next);
+void STATS_Block(const ACQ_BlockTypeDef *block);
+HAL_StatusTypeDef STATS_SetMode(uint32_t mode);
+uint32_t STATS_GetMode(void);
+HAL_StatusTypeDef STATS_SetWindow(uint32_t ms);
+uint32_t STATS_GetWindow(void);
+const STATS_AxisTypeDef *STATS_GetAxis(uint32_t axis);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STATS_H__ */
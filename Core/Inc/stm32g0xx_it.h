@@ -49,9 +49,14 @@
 void NMI_Handler(void);
 void HardFault_Handler(void);
 void DMA1_Channel1_IRQHandler(void);
+void DMA1_Channel2_3_IRQHandler(void);
+void DMA1_Ch4_5_DMAMUX1_OVR_IRQHandler(void);
 void ADC1_IRQHandler(void);
 void TIM2_IRQHandler(void);
+void LPTIM1_IRQHandler(void);
 void TIM17_IRQHandler(void);
+void USART1_IRQHandler(void);
+void USART2_IRQHandler(void);
 /* USER CODE BEGIN EFP */
 
 /* USER CODE END EFP */
@@ -0,0 +1,141 @@
+/**
+  ******************************************************************************
+  * @file    stream.h
+  * @brief   This file contains all the function prototypes for
+  *          the stream.c file
+  ******************************************************************************
+  * Packet layout, multi-byte fields little-endian:
+  *
+  *   offset  size  field
+  *        0     2  sync      0xA5 0x5A
+  *        2     1  version   STREAM_VERSION
+  *        3     1  type      STREAM_TYPE_xxx
+  *        4     2  seq       packet counter, +1 per packet of any type
+  *        6     2  length    payload bytes, at most STREAM_MAX_PAYLOAD
+  *        8     n  payload
+  *      8+n     2  crc       CRC-16/CCITT-FALSE over bytes 2 .. 8+n-1
+  *
+  * STREAM_TYPE_SAMPLES payload:
+  *        0     4  stamp     ThreadX tick of the first block
+  *        4     4  block     acquisition block counter of the first block
+  *        8     8  time      us at the trigger of the first frame,
+  *                           64-bit, monotonic: frame i was triggered at
+  *                           time + i * period; see ACQ_GetTime
+  *       16     1  frames    frames in the packet
+  *       17     1  channels  samples per frame (x, y, z)
+  *       18     .  samples   frames * channels raw ADC results, uint16,
+  *                           resolution as in the last STREAM_TYPE_META
+  *
+  * STREAM_TYPE_PACKED payload, instead of the above with
+  * STREAM_FORMAT_PACKED:
+  *        0     4  stamp     ThreadX tick of the first block
+  *        4     4  block     acquisition block counter of the first block
+  *        8     8  time      as in STREAM_TYPE_SAMPLES
+  *       16     1  frames    frames in the packet
+  *       17     1  axes      axes sent, bit 0 x, bit 1 y, bit 2 z
+  *       18     1  width     bits per sample, the resolution in use
+  *       19     1  channels  samples per frame, the axes sent
+  *       20     .  samples   frames * channels raw ADC results, frame by
+  *                           frame in x, y, z order, as one little-endian
+  *                           bit stream: sample k holds bits k * width to
+  *                           k * width + width - 1. At 12 bits two samples
+  *                           take three bytes; every acquisition block
+  *                           ends on a byte boundary.
+  *
+  * STREAM_TYPE_META payload, sent before the first block, whenever the
+  * sampling set-up changes and every STREAM_META_BLOCKS blocks:
+  *        0     4  stamp     ThreadX tick of the block it applies from
+  *        4     4  block     acquisition block counter it applies from
+  *        8     4  period    frame period in us, fs = 1e6 / period
+  *       12     2  ratio     hardware oversampling ratio, 1 when off
+  *       14     1  shift     right shift applied to the oversampled sum
+  *       15     1  bits      effective resolution of the samples
+  *       16     1  channels  STREAM_CHANNELS
+  *       17     1  frames    frames per acquisition block
+  *
+  * STREAM_TYPE_PEAKS and STREAM_TYPE_BINS are described in spectrum.h,
+  * STREAM_TYPE_PROFILE in prof.h, STREAM_TYPE_STACK in stackmon.h,
+  * STREAM_TYPE_TRACE in trace.h, STREAM_TYPE_LATENCY in latency.h,
+  * STREAM_TYPE_COND in cond.h, STREAM_TYPE_CAL in cal.h,
+  * STREAM_TYPE_EVENT in event.h, STREAM_TYPE_STATS in stats.h and
+  * STREAM_TYPE_RICE in rice.h.
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __STREAM_H__
+#define __STREAM_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "acq.h"
+#include "rice.h"
+#include "uart_tx.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define STREAM_SYNC0        0xA5U
+#define STREAM_SYNC1        0x5AU
+#define STREAM_VERSION      2U
+
+#define STREAM_TYPE_SAMPLES 1U
+#define STREAM_TYPE_PEAKS   2U
+#define STREAM_TYPE_BINS    3U
+#define STREAM_TYPE_META    4U
+#define STREAM_TYPE_PROFILE 5U
+#define STREAM_TYPE_STACK   6U
+#define STREAM_TYPE_TRACE   7U
+#define STREAM_TYPE_LATENCY 8U
+#define STREAM_TYPE_COND    9U
+#define STREAM_TYPE_CAL     10U
+#define STREAM_TYPE_EVENT   11U
+#define STREAM_TYPE_STATS   12U
+#define STREAM_TYPE_PACKED  13U
+#define STREAM_TYPE_RICE    14U
+
+#define STREAM_HEADER_SIZE  8U
+#define STREAM_CRC_SIZE     2U
+/* Acquisition blocks batched into one samples packet */
+#define STREAM_BATCH_BLOCKS 2U
+#define STREAM_SAMPLES_HEADER_SIZE 18U
+#define STREAM_PACKED_HEADER_SIZE 20U
+#define STREAM_CHANNELS     3U
+#define STREAM_META_SIZE    18U
+/* Blocks between repeated metadata packets, for hosts that attach late */
+#define STREAM_META_BLOCKS  64U
+#define STREAM_MAX_PAYLOAD  (STREAM_PACKED_HEADER_SIZE + STREAM_BATCH_BLOCKS * ACQ_BLOCK_FRAMES * STREAM_CHANNELS * 2U)
+
+/* Sample formats */
+#define STREAM_FORMAT_WORDS  0U  /* uint16 samples, STREAM_TYPE_SAMPLES, or
+                                    STREAM_TYPE_CAL with USE_CAL */
+#define STREAM_FORMAT_PACKED 1U  /* raw codes at their resolution, STREAM_TYPE_PACKED */
+#define STREAM_FORMAT_RICE   2U  /* raw codes, predicted and Rice coded, STREAM_TYPE_RICE */
+#if (USE_RICE)
+#define STREAM_FORMATS       3U
+#else
+#define STREAM_FORMATS       2U
+#endif
+#define STREAM_FORMAT        STREAM_FORMAT_WORDS
+
+/* Axes sent with STREAM_FORMAT_PACKED and STREAM_FORMAT_RICE, bit 0 x */
+#define STREAM_AXES_ALL      0x07U
+#define STREAM_AXES          STREAM_AXES_ALL
+
+/* Exported functions prototypes ---------------------------------------------*/
+UINT STREAM_Init(UART_TX_HandleTypeDef *htx);
+void STREAM_Block(const ACQ_BlockTypeDef *block);
+void STREAM_Describe(const ACQ_BlockTypeDef *block);
+uint32_t STREAM_Send(uint8_t type, const void *payload, uint16_t length);
+uint32_t STREAM_SendPacket(uint8_t type, uint8_t *packet, uint16_t length);
+HAL_StatusTypeDef STREAM_SetFormat(uint32_t format);
+uint32_t STREAM_GetFormat(void);
+HAL_StatusTypeDef STREAM_SetAxes(uint32_t axes);
+uint32_t STREAM_GetAxes(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STREAM_H__ */
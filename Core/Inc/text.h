@@ -0,0 +1,54 @@
+/**
+  ******************************************************************************
+  * @file    text.h
+  * @brief   This file contains all the function prototypes for
+  *          the text.c file
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __TEXT_H__
+#define __TEXT_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "tx_api.h"
+#include "display.h"
+#include "fonts.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* Font12 of the DFP Utilities/Fonts, 7 x 12 cells, one byte per glyph row */
+#define TEXT_FONT         Font12
+#define TEXT_CELL_WIDTH   7U
+#define TEXT_CELL_HEIGHT  12U
+#define TEXT_CELL_PIXELS  (TEXT_CELL_WIDTH * TEXT_CELL_HEIGHT)
+
+/* Text band at the top of the panel, the rest is left to the frame */
+#define TEXT_ROWS         4U
+#define TEXT_COLS         (DISP_WIDTH / TEXT_CELL_WIDTH)
+#define TEXT_HEIGHT       (TEXT_ROWS * TEXT_CELL_HEIGHT)
+
+/* Expanded glyphs kept, TEXT_CELL_PIXELS * 2 bytes each; at least 2, as
+   the most recently drawn one may still be going out by DMA. Three keep
+   the digits a changing readout redraws and cost 504 bytes. */
+#define TEXT_CACHE_GLYPHS 3U
+
+/* Attributes, colour pairs of text_palette */
+#define TEXT_NORMAL       0U  /* white on black */
+#define TEXT_INVERSE      1U  /* black on white */
+#define TEXT_ALARM        2U  /* yellow on red */
+#define TEXT_ATTRS        3U
+
+/* Exported functions prototypes ---------------------------------------------*/
+UINT TEXT_Init(void);
+void TEXT_Print(uint32_t row, uint32_t col, const char *s, uint8_t attr);
+void TEXT_Number(uint32_t row, uint32_t col, int32_t value, uint32_t width, uint8_t attr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TEXT_H__ */
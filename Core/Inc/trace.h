@@ -0,0 +1,91 @@
+/**
+  ******************************************************************************
+  * @file    trace.h
+  * @brief   This file contains all the function prototypes for
+  *          the trace.c file
+  ******************************************************************************
+  * STREAM_TYPE_TRACE payload, sent by the trace thread. Two kinds:
+  *
+  * TRACE_KIND_IMAGE, a piece of the trace area before the event ring, that
+  * is the TX_TRACE_HEADER and the object registry:
+  *        0     1  kind      TRACE_KIND_IMAGE
+  *        1     1  reserved
+  *        2     2  offset    byte offset from the start of the trace area
+  *        4     n  bytes     as in memory
+  *
+  * TRACE_KIND_EVENTS, ring entries in the order ThreadX wrote them:
+  *        0     1  kind      TRACE_KIND_EVENTS
+  *        1     1  count     entries that follow
+  *        2     2  reserved
+  *        4     4  index     running number of the first entry; entries
+  *                           overwritten before they were sent leave a gap
+  *        8  32*n  entries   TX_TRACE_BUFFER_ENTRY as in memory
+  *
+  * Time stamps count core clock cycles, see TRACE_Time.
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "tx_api.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* USE_TRACE, in tx_user.h since the kernel needs it too, turns the trace on.
+   Costs about 1.8 KB of RAM: the area, the thread and its stack and the
+   packet buffer. */
+
+/* ThreadX trace area: a 40-byte header, 32 bytes per registry entry and 18
+   ring entries of 32 bytes, which hold a drain period of events up to about
+   900 events/s */
+#define TRACE_AREA_SIZE        1024U
+/* Objects the registry can name, TX_TRACE_OBJECT_REGISTRY_NAME bytes each */
+#define TRACE_REGISTRY_ENTRIES 12U
+
+#define TRACE_STACK_SIZE       320U
+/* Lowest priority: the drain only runs when nothing else has work */
+#define TRACE_PRIORITY         (TX_MAX_PRIORITIES - 1U)
+/* Ticks between drains, and event packets per drain at most */
+#define TRACE_PERIOD           20U
+#define TRACE_BURST            4U
+/* Stream bytes still queued above which a drain is skipped */
+#define TRACE_PENDING_MAX      128U
+/* Ticks between repeats of the header and registry, for hosts that attach late */
+#define TRACE_IMAGE_PERIOD     5000U
+
+#define TRACE_KIND_IMAGE       0U
+#define TRACE_KIND_EVENTS      1U
+#define TRACE_ENTRY_SIZE       32U
+#define TRACE_EVENTS_HEADER    8U
+#define TRACE_EVENTS_MAX       6U
+#define TRACE_IMAGE_HEADER     4U
+#define TRACE_IMAGE_CHUNK      192U
+
+/* Exported macro ------------------------------------------------------------*/
+/* Bracket interrupt handler bodies, the IRQ number identifies the ISR in TraceX */
+#ifdef TX_ENABLE_EVENT_TRACE
+#define TRACE_ISR_ENTER(irqn) tx_trace_isr_enter_insert((ULONG)(irqn))
+#define TRACE_ISR_EXIT(irqn)  tx_trace_isr_exit_insert((ULONG)(irqn))
+#else
+#define TRACE_ISR_ENTER(irqn)
+#define TRACE_ISR_EXIT(irqn)
+#endif
+
+/* Exported variables --------------------------------------------------------*/
+extern volatile uint32_t trace_lost;
+
+/* Exported functions prototypes ---------------------------------------------*/
+UINT TRACE_Init(void);
+ULONG TRACE_Time(VOID);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TRACE_H__ */
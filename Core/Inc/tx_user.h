@@ -116,9 +116,10 @@
    disabled. When the following is defined, ThreadX thread stack checking is enabled.  If stack
    checking is enabled (TX_ENABLE_STACK_CHECKING is defined), the TX_DISABLE_STACK_FILLING
    define is negated, thereby forcing the stack fill which is necessary for the stack checking
-   logic.  */
+   logic. Overflows are reported to stackmon.c, which also measures the peak use of every
+   stack from the fill.  */
 
-/*#define TX_ENABLE_STACK_CHECKING*/
+#define TX_ENABLE_STACK_CHECKING
 
 /* Determine if preemption-threshold should be disabled. By default, preemption-threshold is
    enabled. If the application does not use preemption-threshold, it may be disabled to reduce
@@ -145,6 +146,20 @@
 #endif
 */
 
+/* Determine if the scheduler idle loop of the port calls tx_low_power_enter and
+   tx_low_power_exit around WFI, see lowpower.c. The port assembly files do not include
+   this file, so both symbols are also in the assembler defines of the project.  */
+
+#define TX_LOW_POWER
+#define TX_ENABLE_WFI
+
+/* Determine if the port calls the execution profile hooks on every context switch and in
+   SysTick; prof.c implements them on a TIM3 time source since the Cortex-M0+ has no DWT.
+   Also in the assembler defines of the project, as above. Comment out in both places to
+   remove the profiler.  */
+
+#define TX_EXECUTION_PROFILE_ENABLE
+
 /* Determine if the notify callback option should be disabled. By default, notify callbacks are
    enabled. If the application does not use notify callbacks, they may be disabled to reduce
    code size and improve performance.  */
@@ -164,9 +179,24 @@
 
 /* Determine if the trace event logging code should be enabled. This causes slight increases in
    code size and overhead, but provides the ability to generate system trace information which
-   is available for viewing in TraceX.  */
-
-/*#define TX_ENABLE_EVENT_TRACE*/
+   is available for viewing in TraceX. trace.c streams the trace to the host; the M0+ port
+   has no cycle counter to stamp events with, so TRACE_Time uses LP_Cycles, built from the
+   kernel tick and SysTick. Registry names are cut to 16 bytes to keep the trace area small.
+   The trace costs about 1.8 KB of RAM, which the 8 KB part cannot spare next to the
+   default modules: set USE_TRACE to 1 only with others turned off, see trace.h.  */
+
+#define USE_TRACE 0
+
+#if (USE_TRACE)
+#define TX_ENABLE_EVENT_TRACE
+#define TX_TRACE_OBJECT_REGISTRY_NAME            16
+#define TX_TRACE_TIME_SOURCE                     TRACE_Time()
+#define TX_TRACE_TIME_MASK                       0xFFFFFFFFUL
+
+#if !defined(__ASSEMBLER__) && !defined(__IAR_SYSTEMS_ASM__)
+unsigned long TRACE_Time(void);
+#endif
+#endif
 
 /* Determine if block pool performance gathering is required by the application. When the following is
    defined, ThreadX gathers various block pool performance information. */
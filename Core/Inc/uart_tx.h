@@ -0,0 +1,53 @@
+/**
+  ******************************************************************************
+  * @file    uart_tx.h
+  * @brief   This file contains all the function prototypes for
+  *          the uart_tx.c file
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __UART_TX_H__
+#define __UART_TX_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "tx_api.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* Largest copy made with interrupts disabled */
+#define UART_TX_CHUNK 32U
+/* Ticks a thread waits for room before it restarts the DMA itself */
+#define UART_TX_RETRY 10U
+
+/* Exported types ------------------------------------------------------------*/
+/* Runs in the completion interrupt once the last byte has left the shifter */
+typedef void (*UART_TX_IdleTypeDef)(UART_HandleTypeDef *huart);
+
+typedef struct {
+    UART_HandleTypeDef *huart;
+    uint8_t *buf;
+    uint16_t mask;              /* ring size - 1 */
+    volatile uint16_t head;     /* free-running write index */
+    volatile uint16_t tail;     /* free-running read index, advanced on DMA completion */
+    volatile uint16_t inflight; /* bytes handed to the DMA */
+    volatile uint32_t dropped;  /* bytes discarded by non-blocking writers or a DMA error */
+    TX_SEMAPHORE space;         /* put on every DMA completion */
+    TX_MUTEX lock;              /* keeps one thread's buffer contiguous on the wire */
+    UART_TX_IdleTypeDef idle;   /* optional, set after UART_TX_Init */
+} UART_TX_HandleTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+UINT UART_TX_Init(UART_TX_HandleTypeDef *htx, UART_HandleTypeDef *huart, uint8_t *buf, uint16_t size);
+uint32_t UART_TX_Write(UART_TX_HandleTypeDef *htx, const uint8_t *data, uint32_t len);
+uint32_t UART_TX_Pending(const UART_TX_HandleTypeDef *htx);
+void UART_TX_ErrorCallback(UART_HandleTypeDef *huart);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UART_TX_H__ */
@@ -29,7 +29,7 @@ extern "C" {
 #include "main.h"
 
 /* USER CODE BEGIN Includes */
-
+#include "uart_tx.h"
 /* USER CODE END Includes */
 
 extern UART_HandleTypeDef huart1;
@@ -37,14 +37,37 @@ extern UART_HandleTypeDef huart1;
 extern UART_HandleTypeDef huart2;
 
 /* USER CODE BEGIN Private defines */
-#define USE_RS485 1
+/* stdout and the sample stream on the RS485 port instead of USART1 */
+#define USE_RS485 0
+/* Modbus RTU slave on the RS485 port, see modbus.h. Off by default: it
+   keeps the core out of STOP1, see lowpower.c, and costs about 1.3 KB of
+   RAM, which the 8 KB part cannot spare next to the default modules: set
+   it to 1 only with others, such as USE_EVENT, turned off */
+#ifndef USE_MODBUS
+#define USE_MODBUS 0
+#endif
+
+#if (USE_RS485 && USE_MODBUS)
+#error "USE_RS485 and USE_MODBUS both need USART2"
+#endif
+
+#if (USE_RS485)
+#define STDOUT_UART huart2
+#else
+#define STDOUT_UART huart1
+#endif
+
+/* Ring size of the stdout transmit engine, must be a power of two */
+#define UART_TX_STDOUT_SIZE 512U
 /* USER CODE END Private defines */
 
 void MX_USART1_UART_Init(void);
 void MX_USART2_UART_Init(void);
 
 /* USER CODE BEGIN Prototypes */
+extern UART_TX_HandleTypeDef uart_tx_stdout;
 
+UINT USART_Stdout_Init(void);
 /* USER CODE END Prototypes */
 
 #ifdef __cplusplus
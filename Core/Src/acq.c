@@ -0,0 +1,405 @@
+/**
+  ******************************************************************************
+  * @file    acq.c
+  * @brief   Block acquisition of the ADXL channels.
+  *          Blocks of ACQ_BLOCK_FRAMES frames come from a ThreadX block pool
+  *          and DMA1_Channel1 fills them in place, one transfer per block.
+  *          The transfer-complete interrupt arms the channel on a fresh
+  *          block and hands the full one on by pointer: to every subscribed
+  *          queue and, through the deferred-work queue, to the consumer in
+  *          the output thread. Each holder releases its reference and the
+  *          last one returns the block to the pool, so samples are never
+  *          copied and RAM use is fixed at ACQ_POOL_BLOCKS blocks.
+  *          A conversion that ends before the channel is armed again
+  *          overruns the ADC and would land one channel late in the next
+  *          block; the error interrupt restarts ADC and DMA together on the
+  *          block being filled, which counts as lost.
+  *          Hardware oversampling sums up to 256 conversions per trigger
+  *          into one result; when the conversions no longer fit in a frame
+  *          period the TIM1 period is doubled until they do, trading output
+  *          rate for resolution without extra DMA traffic.
+  *          Block times are measured, not counted: TIM1 TRGO2 triggers the
+  *          frames and TIM2 free-runs as a 32-bit 1 MHz clock. The transfer-
+  *          complete interrupt latches both; TIM2 less the TIM1 count is the
+  *          trigger of the last frame, and the block began ACQ_BLOCK_FRAMES
+  *          - 1 periods before that. The TIM2 count is widened to 64 bits
+  *          on every block, and a run is anchored to the kernel clock when
+  *          TIM2 may have stopped in STOP1, so frames lost to an overrun or
+  *          a late interrupt show as a step in time and a run is never
+  *          placed before the one it follows.
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "acq.h"
+#include "adc.h"
+#include "tim.h"
+#include "defer.h"
+#include "lowpower.h"
+#include "latency.h"
+
+/* Blocks travel by pointer in ULONG queue messages and deferred job
+   arguments; on the host that takes the 32-bit Linux port */
+_Static_assert(sizeof(ACQ_BlockTypeDef *) <= sizeof(ULONG), "a block pointer must fit in a ULONG");
+
+/* Private typedef -----------------------------------------------------------*/
+/* One pool block; block comes first so both share an address */
+typedef struct {
+    ACQ_BlockTypeDef block;
+    ACQ_ConfigTypeDef config;
+    ACQ_FrameTypeDef frames[ACQ_BLOCK_FRAMES];
+} ACQ_SlotTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+static TX_BLOCK_POOL acq_pool;
+/* ThreadX keeps one pointer in front of every block */
+static ULONG acq_pool_storage[ACQ_POOL_BLOCKS * ((sizeof(ACQ_SlotTypeDef) + sizeof(VOID *) + sizeof(ULONG) - 1U) / sizeof(ULONG))];
+/* Block the DMA is filling */
+static ACQ_SlotTypeDef *acq_filling;
+static TX_QUEUE *acq_subscribers[ACQ_MAX_SUBSCRIBERS];
+static ACQ_CallbackTypeDef acq_callback;
+static uint32_t acq_seq;
+/* Holds the clocks out of STOP1 while the ADC is running */
+static uint8_t acq_running;
+static ACQ_ConfigTypeDef acq_config = {ACQ_BASE_PERIOD_US, 1U, 0U, ACQ_ADC_BITS, 0U};
+/* Time in us at the TIM2 count acq_mark, moved on at every block */
+static uint64_t acq_time;
+static uint32_t acq_mark;
+
+/* Indexed by log2(ratio) - 1 and by shift */
+static const uint32_t acq_ovs_ratio[] = {
+    ADC_OVERSAMPLING_RATIO_2,  ADC_OVERSAMPLING_RATIO_4,  ADC_OVERSAMPLING_RATIO_8,
+    ADC_OVERSAMPLING_RATIO_16, ADC_OVERSAMPLING_RATIO_32, ADC_OVERSAMPLING_RATIO_64,
+    ADC_OVERSAMPLING_RATIO_128, ADC_OVERSAMPLING_RATIO_256
+};
+static const uint32_t acq_ovs_shift[] = {
+    ADC_RIGHTBITSHIFT_NONE, ADC_RIGHTBITSHIFT_1, ADC_RIGHTBITSHIFT_2,
+    ADC_RIGHTBITSHIFT_3, ADC_RIGHTBITSHIFT_4
+};
+
+volatile uint32_t acq_overruns;
+
+/* Private function prototypes -----------------------------------------------*/
+static void ACQ_Post(ACQ_SlotTypeDef *slot);
+static void ACQ_Deliver(ULONG slot, ULONG stamp);
+static uint64_t ACQ_Latch(void);
+
+/**
+  * @brief  Create the block pool and set the consumer the blocks are handed to.
+  * @note   Must run from tx_application_define, after DEFER_Init and before ACQ_Start.
+  * @param  callback : consumer, runs in the output thread
+  * @retval ThreadX status
+  */
+UINT ACQ_Init(ACQ_CallbackTypeDef callback)
+{
+    acq_callback = callback;
+    acq_seq      = 0;
+    acq_overruns = 0;
+    acq_filling  = NULL;
+    acq_time     = 0;
+    acq_mark     = 0;
+#if (USE_LATENCY)
+    LAT_Init();
+#endif
+    return tx_block_pool_create(&acq_pool, "acq pool", sizeof(ACQ_SlotTypeDef),
+                                acq_pool_storage, sizeof(acq_pool_storage));
+}
+
+/**
+  * @brief  Hand every block to a queue as well, by pointer.
+  * @note   The queue takes one-ULONG messages holding an ACQ_BlockTypeDef
+  *         pointer; whoever receives one must ACQ_Release it. A full queue
+  *         misses the block and counts an overrun.
+  * @param  queue : receiving queue
+  * @retval ThreadX status
+  */
+UINT ACQ_Subscribe(TX_QUEUE *queue)
+{
+    uint32_t i;
+
+    for (i = 0; i < ACQ_MAX_SUBSCRIBERS; i++) {
+        if (acq_subscribers[i] == NULL) {
+            acq_subscribers[i] = queue;
+            return TX_SUCCESS;
+        }
+    }
+    return TX_SIZE_ERROR;
+}
+
+/**
+  * @brief  Take another reference to a block.
+  * @param  block : block already held by the caller
+  * @retval None
+  */
+void ACQ_Retain(const ACQ_BlockTypeDef *block)
+{
+    TX_INTERRUPT_SAVE_AREA
+
+    TX_DISABLE
+    ((ACQ_BlockTypeDef *)block)->refs++;
+    TX_RESTORE
+}
+
+/**
+  * @brief  Drop a reference; the last one returns the block to the pool.
+  * @note   Callable from threads and ISRs.
+  * @param  block : block held by the caller, not to be touched afterwards
+  * @retval None
+  */
+void ACQ_Release(const ACQ_BlockTypeDef *block)
+{
+    TX_INTERRUPT_SAVE_AREA
+    uint32_t refs;
+
+    TX_DISABLE
+    refs = --((ACQ_BlockTypeDef *)block)->refs;
+    TX_RESTORE
+    if (refs == 0U) {
+        tx_block_release((VOID *)block);
+    }
+}
+
+/**
+  * @brief  Start DMA of ADC1 into a pool block.
+  *         Conversions are paced by TIM1 TRGO2.
+  * @retval HAL status
+  */
+HAL_StatusTypeDef ACQ_Start(void)
+{
+    HAL_StatusTypeDef status;
+    uint64_t now, time;
+    uint32_t mark;
+
+    if (acq_filling == NULL &&
+        tx_block_allocate(&acq_pool, (VOID **)&acq_filling, TX_NO_WAIT) != TX_SUCCESS) {
+        acq_filling = NULL;
+        return HAL_ERROR;
+    }
+    if (!acq_running) {
+        /* TIM2 carries on from the last block unless it stopped in STOP1
+           or wrapped meanwhile; then the kernel clock is ahead of it */
+        mark = __HAL_TIM_GET_COUNTER(&htim2);
+        time = acq_time + (uint32_t)(mark - acq_mark);
+        now  = (uint64_t)tx_time_get() * (1000000UL / TX_TIMER_TICKS_PER_SECOND);
+        acq_time = (now > time) ? now : time;
+        acq_mark = mark;
+    }
+    status = HAL_ADC_Start_DMA(&hadc1, (uint32_t *)acq_filling->frames, ACQ_BLOCK_FRAMES * ACQ_CHANNELS);
+    if (status == HAL_OK && !acq_running) {
+        acq_running = 1;
+        LP_Hold();
+    }
+    return status;
+}
+
+/**
+  * @brief  Stop the acquisition. Blocks already handed on still reach
+  *         their consumers; the partly filled one goes back to the pool.
+  * @retval HAL status
+  */
+HAL_StatusTypeDef ACQ_Stop(void)
+{
+    HAL_StatusTypeDef status = HAL_ADC_Stop_DMA(&hadc1);
+
+    if (acq_filling != NULL) {
+        tx_block_release(acq_filling);
+        acq_filling = NULL;
+    }
+    if (acq_running) {
+        acq_running = 0;
+        LP_Release();
+    }
+    return status;
+}
+
+/**
+  * @brief  Whether ACQ_Start has run without a matching ACQ_Stop.
+  * @retval 1 when running, 0 otherwise
+  */
+uint8_t ACQ_IsRunning(void)
+{
+    return acq_running;
+}
+
+/**
+  * @brief  Select the hardware oversampling ratio, restarting a running
+  *         acquisition. The sum is shifted just enough to fit 16 bits, so
+  *         the resolution grows by one bit per doubling up to 16 bits.
+  * @note   Thread context only. Run it from the output thread (DEFER_Post)
+  *         so that no consumer is looking at the old set-up meanwhile.
+  * @param  ratio : 1 (off), 2, 4 ... ACQ_OVS_MAX
+  * @retval HAL status
+  */
+HAL_StatusTypeDef ACQ_SetOversampling(uint32_t ratio)
+{
+    HAL_StatusTypeDef status = HAL_OK;
+    uint32_t log2 = 0, shift, period, busy_us;
+    uint8_t running = acq_running;
+
+    while ((1UL << log2) < ratio) {
+        log2++;
+    }
+    if (ratio == 0U || ratio > ACQ_OVS_MAX || (1UL << log2) != ratio) {
+        return HAL_ERROR;
+    }
+    shift = (ACQ_ADC_BITS + log2 > ACQ_MAX_BITS) ? ACQ_ADC_BITS + log2 - ACQ_MAX_BITS : 0U;
+
+    /* All ratio x channels conversions run back to back on one trigger,
+       leave 10 % of the period spare */
+    busy_us = ratio * ACQ_FRAME_CYCLES / ACQ_ADC_MHZ;
+    period  = ACQ_BASE_PERIOD_US;
+    while (busy_us * 10U > period * 9U) {
+        period *= 2U;
+    }
+
+    if (running) {
+        ACQ_Stop();
+    }
+    hadc1.Init.OversamplingMode = (log2 != 0U) ? ENABLE : DISABLE;
+    if (log2 != 0U) {
+        hadc1.Init.Oversampling.Ratio         = acq_ovs_ratio[log2 - 1U];
+        hadc1.Init.Oversampling.RightBitShift = acq_ovs_shift[shift];
+        hadc1.Init.Oversampling.TriggeredMode = ADC_TRIGGEREDMODE_SINGLE_TRIGGER;
+    }
+    if (HAL_ADC_Init(&hadc1) != HAL_OK) {
+        status = HAL_ERROR;
+    }
+    __HAL_TIM_SET_AUTORELOAD(&htim1, period - 1U);
+    __HAL_TIM_SET_COUNTER(&htim1, 0U);
+
+    acq_config.period_us = period;
+    acq_config.ratio     = (uint16_t)ratio;
+    acq_config.shift     = (uint8_t)shift;
+    acq_config.bits      = (uint8_t)(ACQ_ADC_BITS + log2 - shift);
+    acq_config.generation++;
+
+    if (running && status == HAL_OK) {
+        status = ACQ_Start();
+    }
+    return status;
+}
+
+/**
+  * @brief  Current sampling set-up.
+  * @retval Set-up, also referenced by every block
+  */
+const ACQ_ConfigTypeDef *ACQ_GetConfig(void)
+{
+    return &acq_config;
+}
+
+/**
+  * @brief  Time of a block: the TIM1 update that triggered its first frame,
+  *         in microseconds since the kernel started.
+  * @note   Measured to a microsecond within a run; a run is placed to a
+  *         kernel tick. Never goes backwards. A transfer-complete interrupt
+  *         held off past the next trigger places its block a period late.
+  * @param  block : block held by the caller
+  * @retval Time, us
+  */
+uint64_t ACQ_GetTime(const ACQ_BlockTypeDef *block)
+{
+    return block->time;
+}
+
+/* ISR side: stamp the block and hand it on, nothing else */
+static void ACQ_Post(ACQ_SlotTypeDef *slot)
+{
+    ACQ_BlockTypeDef *block = &slot->block;
+    uint32_t i;
+    ULONG msg = (ULONG)block;
+
+    slot->config  = acq_config;
+    block->frames = slot->frames;
+    block->seq    = acq_seq++;
+    block->stamp  = tx_time_get();
+    block->config = &slot->config;
+#if (USE_LATENCY)
+    LAT_Stamp(block);
+#endif
+    /* The output thread's reference, dropped in ACQ_Deliver */
+    block->refs = 1;
+
+    for (i = 0; i < ACQ_MAX_SUBSCRIBERS && acq_subscribers[i] != NULL; i++) {
+        block->refs++;
+        if (tx_queue_send(acq_subscribers[i], &msg, TX_NO_WAIT) != TX_SUCCESS) {
+            block->refs--;
+            acq_overruns++;
+        }
+    }
+    if (DEFER_Post(ACQ_Deliver, msg) != TX_SUCCESS) {
+        acq_overruns++;
+        ACQ_Release(block);
+    }
+}
+
+/* ISR side: time of the trigger of the frame just converted */
+static uint64_t ACQ_Latch(void)
+{
+    uint32_t count = __HAL_TIM_GET_COUNTER(&htim2);
+    uint32_t since = __HAL_TIM_GET_COUNTER(&htim1);
+
+    acq_time += (uint32_t)(count - acq_mark);
+    acq_mark  = count;
+    return acq_time - since;
+}
+
+/* Thread side: run the consumer, then drop the reference */
+static void ACQ_Deliver(ULONG slot, ULONG stamp)
+{
+    const ACQ_BlockTypeDef *block = (const ACQ_BlockTypeDef *)slot;
+
+#if (USE_LATENCY)
+    LAT_Record(block);
+#endif
+    if (acq_callback != NULL) {
+        acq_callback(block);
+    }
+    ACQ_Release(block);
+}
+
+/**
+  * @brief  A block is full: arm the DMA on a fresh one and pass the full one on.
+  * @param  hadc : ADC handle
+  * @retval None
+  */
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
+{
+    ACQ_SlotTypeDef *done = acq_filling;
+    uint64_t last;
+
+    if (hadc->Instance != ADC1 || done == NULL) {
+        return;
+    }
+    last = ACQ_Latch();
+    if (tx_block_allocate(&acq_pool, (VOID **)&acq_filling, TX_NO_WAIT) != TX_SUCCESS) {
+        /* Every block is still held: fill this one again, losing its frames */
+        acq_filling = done;
+        done        = NULL;
+        acq_seq++;
+        acq_overruns++;
+    }
+    ADC1_DMA_Rearm((uint16_t *)acq_filling->frames, ACQ_BLOCK_FRAMES * ACQ_CHANNELS);
+    if (done != NULL) {
+        done->block.time = last - (uint64_t)(ACQ_BLOCK_FRAMES - 1U) * acq_config.period_us;
+        ACQ_Post(done);
+    }
+}
+
+/**
+  * @brief  ADC overrun: a result is waiting in DR that the DMA missed, and
+  *         every later one would be stored a channel late. Restart the
+  *         sequence and the DMA in step on the block being filled; what it
+  *         held is dropped and counted like a lost block.
+  * @param  hadc : ADC handle
+  * @retval None
+  */
+void HAL_ADC_ErrorCallback(ADC_HandleTypeDef *hadc)
+{
+    if (hadc->Instance != ADC1 || acq_filling == NULL || (HAL_ADC_GetError(hadc) & HAL_ADC_ERROR_OVR) == 0U) {
+        return;
+    }
+    (void)HAL_ADC_Stop_DMA(hadc);
+    acq_seq++;
+    acq_overruns++;
+    (void)HAL_ADC_Start_DMA(hadc, (uint32_t *)acq_filling->frames, ACQ_BLOCK_FRAMES * ACQ_CHANNELS);
+}
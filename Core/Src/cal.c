@@ -0,0 +1,152 @@
+/**
+  ******************************************************************************
+  * @file    cal.c
+  * @brief   VREFINT-ratiometric calibration of the accelerometer channels.
+  *          ADC results are fractions of VDDA, so a drifting supply shows
+  *          up as fake acceleration. Every frame also converts VREFINT,
+  *          whose result at Vref+ = VREFINT_CAL_VREF the factory stores
+  *          as VREFINT_CAL. At any resolution
+  *
+  *            V = VREFINT_CAL_VREF * VREFINT_CAL * code / (4095 * vrefint)
+  *
+  *          and a = V / sensitivity - offset, with the per-axis constants
+  *          of cal.h. Integer only, block by block in the output thread:
+  *          the block's VREFINT results are summed, which also averages
+  *          their noise, one division per axis turns the sum into a gain
+  *          in mg per code, and each sample then costs a multiply, a shift
+  *          and a subtraction. The M0+ has neither an FPU nor a divider.
+  *          See cal.h for the packet layout.
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "cal.h"
+#include "stream.h"
+
+#if (USE_CAL)
+
+/* Private define ------------------------------------------------------------*/
+#define CAL_AXES        3U
+/* Full scale of the 12-bit results VREFINT_CAL was taken with */
+#define CAL_FULL_SCALE  4095U
+/* Highest VDDA of the STM32G0; lower VREFINT sums are taken as faulty */
+#define CAL_VDDA_MAX_MV 3600U
+
+/* Private variables ---------------------------------------------------------*/
+static const uint16_t cal_zero_mv[CAL_AXES] = {
+    CAL_X_ZERO_MV, CAL_Y_ZERO_MV, CAL_Z_ZERO_MV
+};
+static const uint16_t cal_mv_per_g[CAL_AXES] = {
+    CAL_X_MV_PER_G, CAL_Y_MV_PER_G, CAL_Z_MV_PER_G
+};
+
+static uint16_t cal_vrefint;
+/* Per axis: gain times the block's VREFINT sum, and the offset in mg */
+static uint64_t cal_num[CAL_AXES];
+static int32_t cal_zero_mg[CAL_AXES];
+static volatile uint32_t cal_vdda;
+static uint8_t cal_payload[CAL_HEADER_SIZE + ACQ_BLOCK_FRAMES * STREAM_CHANNELS * 2U];
+
+/* Private functions ---------------------------------------------------------*/
+static inline void CAL_Put16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void CAL_Put32(uint8_t *p, uint32_t v)
+{
+    CAL_Put16(p, (uint16_t)v);
+    CAL_Put16(p + 2, (uint16_t)(v >> 16));
+}
+
+/**
+  * @brief  Read VREFINT_CAL and fold the per-axis constants into the gains.
+  * @note   Call before ACQ_Init.
+  * @retval None
+  */
+void CAL_Init(void)
+{
+    uint32_t axis;
+
+    cal_vrefint = *VREFINT_CAL_ADDR;
+    if (cal_vrefint == 0U || cal_vrefint == 0xFFFFU) {
+        cal_vrefint = CAL_VREFINT_NOMINAL;
+    }
+    for (axis = 0; axis < CAL_AXES; axis++) {
+        /* mg per code << CAL_GAIN_BITS, times ACQ_BLOCK_FRAMES * vrefint */
+        cal_num[axis] = (((uint64_t)VREFINT_CAL_VREF * cal_vrefint * ACQ_BLOCK_FRAMES * 1000U) << CAL_GAIN_BITS) /
+                        ((uint64_t)CAL_FULL_SCALE * cal_mv_per_g[axis]);
+        cal_zero_mg[axis] = (int32_t)((cal_zero_mv[axis] * 1000U + cal_mv_per_g[axis] / 2U) / cal_mv_per_g[axis]);
+    }
+    cal_vdda = 0;
+}
+
+/**
+  * @brief  Convert a block to mg and send it.
+  * @note   Matches ACQ_CallbackTypeDef. With a format other than
+  *         STREAM_FORMAT_WORDS the raw block goes to STREAM_Block instead.
+  * @param  block : finished block
+  * @retval None
+  */
+void CAL_Block(const ACQ_BlockTypeDef *block)
+{
+    const uint16_t *raw = (const uint16_t *)block->frames;
+    uint32_t bits = block->config->bits, vsum = 0, min, gain, axis, i;
+    int32_t mg, zero;
+    uint64_t time;
+    uint8_t *out;
+
+    if (STREAM_GetFormat() != STREAM_FORMAT_WORDS) {
+        STREAM_Block(block);
+        return;
+    }
+    STREAM_Describe(block);
+
+    for (i = 0; i < ACQ_BLOCK_FRAMES; i++) {
+        vsum += block->frames[i].vref;
+    }
+    /* VREFINT cannot read lower than at the highest VDDA */
+    min = ((cal_vrefint * ACQ_BLOCK_FRAMES * VREFINT_CAL_VREF) / CAL_VDDA_MAX_MV) << (bits - ACQ_ADC_BITS);
+    if (vsum < min) {
+        vsum = min;
+    }
+    cal_vdda = (uint32_t)(((uint64_t)VREFINT_CAL_VREF * cal_vrefint * ACQ_BLOCK_FRAMES * ((1UL << bits) - 1U)) /
+                          ((uint64_t)CAL_FULL_SCALE * vsum));
+
+    CAL_Put32(&cal_payload[0], block->stamp);
+    CAL_Put32(&cal_payload[4], block->seq);
+    time = ACQ_GetTime(block);
+    CAL_Put32(&cal_payload[8], (uint32_t)time);
+    CAL_Put32(&cal_payload[12], (uint32_t)(time >> 32));
+    cal_payload[16] = ACQ_BLOCK_FRAMES;
+    cal_payload[17] = STREAM_CHANNELS;
+    CAL_Put16(&cal_payload[18], (uint16_t)cal_vdda);
+
+    for (axis = 0; axis < CAL_AXES; axis++) {
+        gain = (uint32_t)((cal_num[axis] + vsum / 2U) / vsum);
+        zero = cal_zero_mg[axis];
+        out  = &cal_payload[CAL_HEADER_SIZE + axis * 2U];
+        for (i = 0; i < ACQ_BLOCK_FRAMES; i++) {
+            mg = (int32_t)((raw[i * ACQ_CHANNELS + axis] * gain + (1UL << (CAL_GAIN_BITS - 1U))) >> CAL_GAIN_BITS) - zero;
+            if (mg > INT16_MAX) {
+                mg = INT16_MAX;
+            } else if (mg < INT16_MIN) {
+                mg = INT16_MIN;
+            }
+            CAL_Put16(out, (uint16_t)mg);
+            out += STREAM_CHANNELS * 2U;
+        }
+    }
+    STREAM_Send(STREAM_TYPE_CAL, cal_payload, sizeof(cal_payload));
+}
+
+/**
+  * @brief  VDDA of the last block.
+  * @retval mV, 0 before the first block
+  */
+uint32_t CAL_GetVdda(void)
+{
+    return cal_vdda;
+}
+
+#endif /* USE_CAL */
@@ -0,0 +1,309 @@
+/**
+  ******************************************************************************
+  * @file    cond.c
+  * @brief   Fixed-point conditioning of the samples before they are streamed.
+  *          Raw results carry the DC and gravity offset of each axis and
+  *          noise up to fs / 2, which the host would otherwise receive at
+  *          the full frame rate. Per axis and block by block, in the output
+  *          thread: the DC estimate is removed and the result scaled to
+  *          q15, a 4th order Butterworth low-pass runs as a cascade of two
+  *          biquads (arm_biquad_cascade_df1_fast_q15), and an FIR decimator
+  *          (arm_fir_decimate_fast_q15) keeps one frame in M. The low-pass
+  *          cuts at 0.35 of the output Nyquist rate and the decimator's
+  *          zeros sit on the alias bands, so together they hold aliases
+  *          into the lower half of the output band some 37 dB down.
+  *          Filter state is kept across blocks and reset when the preset
+  *          or the sampling set-up changes. Presets are coefficient sets,
+  *          selectable at run time; see cond.h for the packet layout.
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "cond.h"
+#include "stream.h"
+#include "cal.h"
+#include "arm_math.h"
+
+#if (USE_COND)
+
+/* Private define ------------------------------------------------------------*/
+#define COND_AXES 3U
+
+#if (COND_BATCH_FRAMES % ACQ_BLOCK_FRAMES) != 0U || (ACQ_BLOCK_FRAMES % 16U) != 0U
+#error "ACQ_BLOCK_FRAMES must be a multiple of 16, the largest M, and divide COND_BATCH_FRAMES"
+#endif
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct {
+    const q15_t *biquad;  /* COND_STAGES * 6 coefficients, Q14 */
+    const q15_t *fir;     /* taps coefficients, NULL without decimation */
+    uint16_t taps;
+    uint8_t decimation;   /* M */
+} COND_PresetTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+/* { b0, 0, b1, b2, -a1, -a2 } per section, as arm_biquad_cascade_df1_init_q15
+   takes them with a postShift of 1 */
+static const q15_t cond_lp[COND_STAGES * 6U] = {
+      1451,      0,   2903,   1451,  14015,  -3436,
+      1888,      0,   3777,   1888,  18236,  -9405
+};
+static const q15_t cond_lp4[COND_STAGES * 6U] = {
+       814,      0,   1628,    814,  18843,  -5716,
+      1006,      0,   2012,   1006,  23284, -10924
+};
+static const q15_t cond_lp8[COND_STAGES * 6U] = {
+       246,      0,    492,    246,  25214,  -9814,
+       279,      0,    557,    279,  28570, -13300
+};
+static const q15_t cond_lp16[COND_STAGES * 6U] = {
+        69,      0,    137,     69,  28812, -12702,
+        73,      0,    147,     73,  30842, -14751
+};
+
+/* Hamming windowed sinc, 2 * M taps, cut-off fs / (2 * M), unity gain */
+static const q15_t cond_fir4[8] = {
+       117,  1248,  5277,  9741,  9741,  5277,  1248,   117
+};
+static const q15_t cond_fir8[16] = {
+        27,   131,   450,  1111,  2111,  3280,  4327,  4946,
+      4946,  4327,  3280,  2111,  1111,   450,   131,    27
+};
+static const q15_t cond_fir16[32] = {
+         6,    23,    51,   104,   189,   313,   482,   692,
+       940,  1213,  1497,  1774,  2026,  2234,  2382,  2457,
+      2457,  2382,  2234,  2026,  1774,  1497,  1213,   940,
+       692,   482,   313,   189,   104,    51,    23,     6
+};
+
+static const COND_PresetTypeDef cond_presets[COND_PRESETS] = {
+    [COND_PRESET_OFF]   = { NULL,      NULL,       0,  1 },
+    [COND_PRESET_LP]    = { cond_lp,   NULL,       0,  1 },
+    [COND_PRESET_DEC4]  = { cond_lp4,  cond_fir4,  8,  4 },
+    [COND_PRESET_DEC8]  = { cond_lp8,  cond_fir8,  16, 8 },
+    [COND_PRESET_DEC16] = { cond_lp16, cond_fir16, 32, 16 },
+};
+
+static const COND_PresetTypeDef *cond_preset;
+static uint32_t cond_dc_shift;
+/* Set-up the filter state belongs to */
+static uint32_t cond_generation;
+static uint8_t cond_reset;
+
+/* Per axis state; the DC estimate is in input codes << 14 */
+static int32_t cond_dc[COND_AXES];
+static uint8_t cond_dc_valid;
+static arm_biquad_casd_df1_inst_q15 cond_biquad[COND_AXES];
+static q15_t cond_biquad_state[COND_AXES][4U * COND_STAGES];
+static arm_fir_decimate_instance_q15 cond_fir[COND_AXES];
+static q15_t cond_fir_state[COND_AXES][COND_MAX_TAPS + ACQ_BLOCK_FRAMES - 1U];
+
+/* One axis of one block, kept off the output thread's stack */
+static q15_t cond_in[ACQ_BLOCK_FRAMES];
+static q15_t cond_out[ACQ_BLOCK_FRAMES];
+static uint8_t cond_payload[COND_HEADER_SIZE + COND_BATCH_FRAMES * STREAM_CHANNELS * 2U];
+/* Frames already in the pending packet, and the block it continues with */
+static uint32_t cond_frames;
+static uint32_t cond_next_block;
+
+/* Private function prototypes -----------------------------------------------*/
+static void COND_Reset(void);
+static void COND_Flush(void);
+
+static inline void COND_Put16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void COND_Put32(uint8_t *p, uint32_t v)
+{
+    COND_Put16(p, (uint16_t)v);
+    COND_Put16(p + 2, (uint16_t)(v >> 16));
+}
+
+/**
+  * @brief  Select COND_PRESET and COND_DC_SHIFT.
+  * @note   Call before ACQ_Init.
+  * @retval None
+  */
+void COND_Init(void)
+{
+    cond_preset   = &cond_presets[COND_PRESET];
+    cond_dc_shift = COND_DC_SHIFT;
+    cond_frames   = 0;
+    cond_reset    = 1;
+}
+
+/**
+  * @brief  Condition a block and send the result once COND_BATCH_FRAMES
+  *         frames are in; when off, samples go to CAL_Block or STREAM_Block.
+  * @note   Matches ACQ_CallbackTypeDef. A gap in the block counter closes
+  *         the packet early, the filters carry on over it.
+  * @param  block : finished block
+  * @retval None
+  */
+void COND_Block(const ACQ_BlockTypeDef *block)
+{
+    const uint16_t *raw = (const uint16_t *)block->frames;
+    const COND_PresetTypeDef *preset = cond_preset;
+    uint32_t bits = block->config->bits, m = preset->decimation;
+    uint32_t axis, i, n = ACQ_BLOCK_FRAMES / m;
+    int32_t v, mid = (int32_t)(1UL << (bits - 1U)) << 14;
+    uint64_t time;
+    const q15_t *y;
+    uint8_t *out;
+
+    if (preset == &cond_presets[COND_PRESET_OFF]) {
+#if (USE_CAL)
+        CAL_Block(block);
+#else
+        STREAM_Block(block);
+#endif
+        return;
+    }
+    STREAM_Describe(block);
+    if (cond_reset || block->config->generation != cond_generation) {
+        COND_Flush();
+        COND_Reset();
+        cond_generation = block->config->generation;
+    }
+    if (cond_frames != 0U && block->seq != cond_next_block) {
+        COND_Flush();
+    }
+    if (cond_frames == 0U) {
+        COND_Put32(&cond_payload[0], block->stamp);
+        COND_Put32(&cond_payload[4], block->seq);
+        time = ACQ_GetTime(block);
+        COND_Put32(&cond_payload[8], (uint32_t)time);
+        COND_Put32(&cond_payload[12], (uint32_t)(time >> 32));
+        cond_payload[17] = (uint8_t)m;
+    }
+    cond_next_block = block->seq + 1U;
+
+    if (!cond_dc_valid) {
+        for (axis = 0; axis < COND_AXES; axis++) {
+            cond_dc[axis] = (int32_t)raw[axis] << 14;
+        }
+        cond_dc_valid = 1;
+    }
+    for (axis = 0; axis < COND_AXES; axis++) {
+        /* Input codes << 14, less the DC, to q15: 1.0 is 2^(bits - 1) codes */
+        for (i = 0; i < ACQ_BLOCK_FRAMES; i++) {
+            v = (int32_t)raw[i * ACQ_CHANNELS + axis] << 14;
+            if (cond_dc_shift != 0U) {
+                cond_dc[axis] += (v - cond_dc[axis]) >> cond_dc_shift;
+                v -= cond_dc[axis];
+            } else {
+                v -= mid;
+            }
+            cond_in[i] = clip_q31_to_q15(v >> (bits - 2U));
+        }
+        arm_biquad_cascade_df1_fast_q15(&cond_biquad[axis], cond_in, cond_out, ACQ_BLOCK_FRAMES);
+        y = cond_out;
+        if (preset->fir != NULL) {
+            arm_fir_decimate_fast_q15(&cond_fir[axis], cond_out, cond_in, ACQ_BLOCK_FRAMES);
+            y = cond_in;
+        }
+        out = &cond_payload[COND_HEADER_SIZE + (cond_frames * STREAM_CHANNELS + axis) * 2U];
+        for (i = 0; i < n; i++) {
+            COND_Put16(out, (uint16_t)y[i]);
+            out += STREAM_CHANNELS * 2U;
+        }
+    }
+    cond_frames += n;
+    if (cond_frames == COND_BATCH_FRAMES) {
+        COND_Flush();
+    }
+}
+
+/**
+  * @brief  Select a preset, from the next block on.
+  * @note   Output thread only, as COND_Block.
+  * @param  preset : COND_PRESET_xxx
+  * @retval HAL_ERROR for an unknown preset
+  */
+HAL_StatusTypeDef COND_SetPreset(uint32_t preset)
+{
+    if (preset >= COND_PRESETS) {
+        return HAL_ERROR;
+    }
+    COND_Flush();
+    cond_preset = &cond_presets[preset];
+    cond_reset  = 1;
+    return HAL_OK;
+}
+
+/**
+  * @brief  Preset in use.
+  * @retval COND_PRESET_xxx
+  */
+uint32_t COND_GetPreset(void)
+{
+    return (uint32_t)(cond_preset - cond_presets);
+}
+
+/**
+  * @brief  Set the time constant of the DC removal.
+  * @note   Output thread only, as COND_Block. The estimate carries on.
+  * @param  shift : 2^shift frames, 0 to subtract mid-scale instead
+  * @retval HAL_ERROR above COND_DC_SHIFT_MAX
+  */
+HAL_StatusTypeDef COND_SetDcShift(uint32_t shift)
+{
+    if (shift > COND_DC_SHIFT_MAX) {
+        return HAL_ERROR;
+    }
+    cond_dc_shift = shift;
+    return HAL_OK;
+}
+
+/**
+  * @brief  Time constant of the DC removal.
+  * @retval shift, 0 when off
+  */
+uint32_t COND_GetDcShift(void)
+{
+    return cond_dc_shift;
+}
+
+/**
+  * @brief  Input frames per output frame of the preset in use.
+  * @retval M, 1 without decimation
+  */
+uint32_t COND_GetDecimation(void)
+{
+    return cond_preset->decimation;
+}
+
+/* Start the filters afresh; the DC estimate restarts from the next sample */
+static void COND_Reset(void)
+{
+    const COND_PresetTypeDef *preset = cond_preset;
+    uint32_t axis;
+
+    cond_reset    = 0;
+    cond_dc_valid = 0;
+    for (axis = 0; axis < COND_AXES; axis++) {
+        arm_biquad_cascade_df1_init_q15(&cond_biquad[axis], COND_STAGES, (q15_t *)preset->biquad,
+                                        cond_biquad_state[axis], 1);
+        if (preset->fir != NULL) {
+            (void)arm_fir_decimate_init_q15(&cond_fir[axis], preset->taps, preset->decimation,
+                                            (q15_t *)preset->fir, cond_fir_state[axis],
+                                            ACQ_BLOCK_FRAMES);
+        }
+    }
+}
+
+/* Send the pending packet, if any */
+static void COND_Flush(void)
+{
+    if (cond_frames == 0U) {
+        return;
+    }
+    cond_payload[16] = (uint8_t)cond_frames;
+    STREAM_Send(STREAM_TYPE_COND, cond_payload,
+                (uint16_t)(COND_HEADER_SIZE + cond_frames * STREAM_CHANNELS * 2U));
+    cond_frames = 0;
+}
+
+#endif /* USE_COND */
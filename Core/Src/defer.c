@@ -0,0 +1,78 @@
+/**
+  ******************************************************************************
+  * @file    defer.c
+  * @brief   Deferred work.
+  *          Interrupt handlers keep to the minimum: they stamp the event and
+  *          post a {function, argument} pair to a ThreadX queue, which is
+  *          safe from any context. The output thread sleeps on the queue and
+  *          runs each function in thread context, where it may format, block
+  *          on the UART or take mutexes.
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "defer.h"
+
+/* Private variables ---------------------------------------------------------*/
+static TX_QUEUE defer_queue;
+static ULONG defer_queue_storage[DEFER_QUEUE_DEPTH * (sizeof(DEFER_WorkTypeDef) / sizeof(ULONG))];
+static ULONG defer_seq;
+
+volatile uint32_t defer_dropped;
+
+/**
+  * @brief  Create the work queue.
+  * @note   Must run from tx_application_define, before the first post.
+  * @retval ThreadX status
+  */
+UINT DEFER_Init(void)
+{
+    defer_seq     = 0;
+    defer_dropped = 0;
+    return tx_queue_create(&defer_queue, "defer queue", sizeof(DEFER_WorkTypeDef) / sizeof(ULONG),
+                           defer_queue_storage, sizeof(defer_queue_storage));
+}
+
+/**
+  * @brief  Schedule func(arg) on the output thread.
+  * @note   Never blocks; callable from ISRs, threads and initialisation.
+  * @param  func : work function
+  * @param  arg : passed to func unchanged
+  * @retval TX_SUCCESS, or TX_QUEUE_FULL when the item was dropped
+  */
+UINT DEFER_Post(DEFER_FuncTypeDef func, ULONG arg)
+{
+    TX_INTERRUPT_SAVE_AREA
+    DEFER_WorkTypeDef work;
+    UINT status;
+
+    work.func  = func;
+    work.arg   = arg;
+    work.stamp = tx_time_get();
+
+    TX_DISABLE
+    work.seq = defer_seq++;
+    TX_RESTORE
+
+    status = tx_queue_send(&defer_queue, &work, TX_NO_WAIT);
+    if (status != TX_SUCCESS) {
+        defer_dropped++;
+    }
+    return status;
+}
+
+/**
+  * @brief  Run the next work item.
+  * @note   Called in a loop by the output thread.
+  * @param  wait_option : ThreadX wait option
+  * @retval ThreadX status
+  */
+UINT DEFER_Dispatch(ULONG wait_option)
+{
+    DEFER_WorkTypeDef work;
+    UINT status = tx_queue_receive(&defer_queue, &work, wait_option);
+
+    if (status == TX_SUCCESS && work.func != TX_NULL) {
+        work.func(work.arg, work.stamp);
+    }
+    return status;
+}
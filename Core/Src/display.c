@@ -0,0 +1,462 @@
+/**
+  ******************************************************************************
+  * @file    display.c
+  * @brief   ST7735 TFT on SPI1, drawn in tiles by DMA.
+  *          8 KB of RAM has no room for a 40 KB frame buffer, so a frame is
+  *          rendered a line at a time into one of two tile buffers
+  *          while SPI1 TX DMA sends the other: the CPU fills tile N+1 as
+  *          tile N goes out. Pixels are sent in 16-bit SPI frames, which
+  *          puts the RGB565 high byte first as the panel wants it without
+  *          swapping; commands and their arguments go out polled in 8-bit
+  *          frames. The DFP st7735 component has the same init values but
+  *          sends every pixel and argument through a separate
+  *          LCD_IO_WriteMultipleData call, so it is not used.
+  *          Frames are drawn by a low-priority thread, only after
+  *          DISP_Invalidate and never faster than the governor allows, so
+  *          the display only gets the time acquisition leaves over. Between
+  *          whole frames, modules registered with DISP_AddUpdate redraw
+  *          just what they changed, with DISP_Blit, after DISP_Update.
+  *          A band of lines can also be scrolled in the controller: the
+  *          panel shows it from any of its lines on, wrapping round, so a
+  *          view that moves by a line costs one line, not the band.
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "display.h"
+#include "spi.h"
+#include "lowpower.h"
+
+#if (USE_DISPLAY)
+
+#if (DISP_HEIGHT % DISP_TILE_LINES) != 0U
+#error "DISP_HEIGHT must be a multiple of DISP_TILE_LINES"
+#endif
+
+/* Private define ------------------------------------------------------------*/
+#define DISP_SPI hspi1
+
+/* ST7735 commands */
+#define ST7735_NOP     0x00U
+#define ST7735_SWRESET 0x01U
+#define ST7735_SLPOUT  0x11U
+#define ST7735_NORON   0x13U
+#define ST7735_INVOFF  0x20U
+#define ST7735_DISPON  0x29U
+#define ST7735_CASET   0x2AU
+#define ST7735_RASET   0x2BU
+#define ST7735_RAMWR   0x2CU
+/* Scroll area and start address, not in the DFP st7735.h register map */
+#define ST7735_SCRLAR  0x33U
+#define ST7735_MADCTL  0x36U
+#define ST7735_VSCSAD  0x37U
+#define ST7735_COLMOD  0x3AU
+#define ST7735_FRMCTR1 0xB1U
+#define ST7735_FRMCTR2 0xB2U
+#define ST7735_FRMCTR3 0xB3U
+#define ST7735_INVCTR  0xB4U
+#define ST7735_PWCTR1  0xC0U
+#define ST7735_PWCTR2  0xC1U
+#define ST7735_PWCTR3  0xC2U
+#define ST7735_PWCTR4  0xC3U
+#define ST7735_PWCTR5  0xC4U
+#define ST7735_VMCTR1  0xC5U
+#define ST7735_GMCTRP1 0xE0U
+#define ST7735_GMCTRN1 0xE1U
+
+/* In an init table entry's argument count: a delay in ms follows the arguments */
+#define DISP_DELAY     0x80U
+
+/* Lines of controller RAM. MADCTL MY writes line y to the far end of it,
+   while the panel scans and scrolls it from line 0 */
+#define DISP_RAM_LINES (DISP_HEIGHT + 2U * DISP_Y_OFFSET)
+#define DISP_MY        0x80U
+
+/* Private variables ---------------------------------------------------------*/
+static TX_THREAD disp_thread;
+static uint8_t disp_thread_stack[DISP_STACK_SIZE];
+/* Given by DISP_Invalidate, taken per frame */
+static TX_SEMAPHORE disp_dirty;
+/* Given when a tile has gone out */
+static TX_SEMAPHORE disp_sent;
+static DISP_RenderTypeDef disp_render;
+static DISP_UpdateTypeDef disp_updates[DISP_MAX_UPDATES];
+static uint16_t disp_tiles[2][DISP_TILE_PIXELS];
+/* Pixels of the last DMA transfer started */
+static const uint16_t *disp_sending;
+/* A whole frame is wanted, not just the updates */
+static volatile uint8_t disp_full;
+/* SPI1 is in 16-bit frames */
+static uint8_t disp_wide;
+/* Scrolled band, see DISP_ScrollArea */
+static uint16_t disp_scroll_top;
+static uint16_t disp_scroll_lines;
+
+volatile uint32_t disp_frames;
+
+/* Command, argument count | DISP_DELAY, arguments, delay; ends with a NOP.
+   The values are those of the DFP st7735 component. */
+static const uint8_t disp_init[] = {
+    ST7735_SWRESET, DISP_DELAY, 150,
+    ST7735_SLPOUT,  DISP_DELAY, 120,
+    ST7735_FRMCTR1, 3, 0x01, 0x2C, 0x2D,
+    ST7735_FRMCTR2, 3, 0x01, 0x2C, 0x2D,
+    ST7735_FRMCTR3, 6, 0x01, 0x2C, 0x2D, 0x01, 0x2C, 0x2D,
+    ST7735_INVCTR,  1, 0x07,
+    ST7735_PWCTR1,  3, 0xA2, 0x02, 0x84,
+    ST7735_PWCTR2,  1, 0xC5,
+    ST7735_PWCTR3,  2, 0x0A, 0x00,
+    ST7735_PWCTR4,  2, 0x8A, 0x2A,
+    ST7735_PWCTR5,  2, 0x8A, 0xEE,
+    ST7735_VMCTR1,  1, 0x0E,
+    ST7735_INVOFF,  0,
+    ST7735_MADCTL,  1, DISP_MADCTL,
+    /* 16 bits per pixel */
+    ST7735_COLMOD,  1, 0x05,
+    ST7735_GMCTRP1, 16, 0x02, 0x1C, 0x07, 0x12, 0x37, 0x32, 0x29, 0x2D,
+                        0x29, 0x25, 0x2B, 0x39, 0x00, 0x01, 0x03, 0x10,
+    ST7735_GMCTRN1, 16, 0x03, 0x1D, 0x07, 0x06, 0x2E, 0x2C, 0x29, 0x2D,
+                        0x2E, 0x2E, 0x37, 0x3F, 0x00, 0x00, 0x02, 0x10,
+    ST7735_NORON,   DISP_DELAY, 10,
+    ST7735_NOP
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static void DISP_Thread(ULONG thread_input);
+static void DISP_Reset(void);
+static void DISP_Command(uint8_t command, const uint8_t *args, uint16_t count);
+static void DISP_Window(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
+static void DISP_Wide(uint8_t wide);
+static void DISP_Wait(void);
+static void DISP_Send(const uint16_t *pixels, uint16_t count);
+static void DISP_Frame(void);
+static uint16_t DISP_RamLine(uint16_t y);
+static void DISP_Clear(uint16_t *pixels, uint16_t y, uint16_t lines);
+
+/**
+  * @brief  Create the display thread; it resets and sets up the panel, then
+  *         draws the first frame.
+  * @note   Must run from tx_application_define, after MX_SPI1_Init.
+  * @param  render : draws the frame tile by tile, NULL keeps the panel black
+  * @retval ThreadX status
+  */
+UINT DISP_Init(DISP_RenderTypeDef render)
+{
+    UINT status;
+
+    disp_render = (render != NULL) ? render : DISP_Clear;
+    disp_frames = 0;
+    disp_full   = 1;
+    disp_wide   = 0;
+
+    status = tx_semaphore_create(&disp_dirty, "disp dirty", 1);
+    if (status == TX_SUCCESS) {
+        status = tx_semaphore_create(&disp_sent, "disp sent", 1);
+    }
+    if (status != TX_SUCCESS) {
+        return status;
+    }
+    return tx_thread_create(&disp_thread, "disp thread", DISP_Thread, 0,
+                            disp_thread_stack, DISP_STACK_SIZE,
+                            DISP_PRIORITY, DISP_PRIORITY, TX_NO_TIME_SLICE, TX_AUTO_START);
+}
+
+/**
+  * @brief  Redraw partly after every frame, see DISP_UpdateTypeDef.
+  * @note   Call before the display thread starts, from tx_application_define.
+  * @param  update : called in the display thread
+  * @retval ThreadX status
+  */
+UINT DISP_AddUpdate(DISP_UpdateTypeDef update)
+{
+    uint32_t i;
+
+    for (i = 0; i < DISP_MAX_UPDATES; i++) {
+        if (disp_updates[i] == NULL) {
+            disp_updates[i] = update;
+            return TX_SUCCESS;
+        }
+    }
+    return TX_SIZE_ERROR;
+}
+
+/**
+  * @brief  Ask for a whole new frame; requests before it is drawn merge into one.
+  * @note   Callable from threads and ISRs.
+  * @retval None
+  */
+void DISP_Invalidate(void)
+{
+    disp_full = 1;
+    tx_semaphore_ceiling_put(&disp_dirty, 1);
+}
+
+/**
+  * @brief  Ask for the updates only, at the pace of the governor.
+  * @note   Callable from threads and ISRs.
+  * @retval None
+  */
+void DISP_Update(void)
+{
+    tx_semaphore_ceiling_put(&disp_dirty, 1);
+}
+
+/**
+  * @brief  Draw a rectangle of pixels, by DMA.
+  * @note   Display thread only, from an update. The pixels are sent after
+  *         the call returns: leave them alone until the next DISP_Blit.
+  * @param  x, y : top left corner
+  * @param  w, h : size, w * h pixels row by row
+  * @param  pixels : RGB565
+  * @retval None
+  */
+void DISP_Blit(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *pixels)
+{
+    DISP_Window(x, y, x + w - 1U, y + h - 1U);
+    DISP_Send(pixels, (uint16_t)(w * h));
+}
+
+/**
+  * @brief  A tile for an update to draw a line into, so that it needs no
+  *         buffer of its own.
+  * @note   Display thread only, from an update. The tile is the one not
+  *         going out by DMA; it is free again once the DISP_Blit after the
+  *         one that sends it has returned.
+  * @retval DISP_TILE_PIXELS pixels, DISP_WIDTH at least
+  */
+uint16_t *DISP_Line(void)
+{
+    return (disp_sending == disp_tiles[0]) ? disp_tiles[1] : disp_tiles[0];
+}
+
+/**
+  * @brief  Scroll a band of lines, the rest of the panel stays in place.
+  * @note   Display thread only, from an update. The band shows from its
+  *         own first line until DISP_ScrollTo.
+  * @param  top : first line of the band
+  * @param  lines : lines in the band; those above and below it are fixed
+  * @retval None
+  */
+void DISP_ScrollArea(uint16_t top, uint16_t lines)
+{
+    uint8_t args[6];
+    uint16_t first, rest;
+
+    disp_scroll_top   = top;
+    disp_scroll_lines = lines;
+    /* Fixed RAM lines before the band, then the band, then the rest */
+    first = (DISP_MADCTL & DISP_MY) ? DISP_RamLine(top + lines - 1U) : DISP_RamLine(top);
+    rest  = DISP_RAM_LINES - first - lines;
+    args[0] = (uint8_t)(first >> 8);
+    args[1] = (uint8_t)first;
+    args[2] = (uint8_t)(lines >> 8);
+    args[3] = (uint8_t)lines;
+    args[4] = (uint8_t)(rest >> 8);
+    args[5] = (uint8_t)rest;
+    DISP_Command(ST7735_SCRLAR, args, sizeof(args));
+    DISP_ScrollTo(top);
+}
+
+/**
+  * @brief  Show the scrolled band from one of its lines on.
+  * @note   Display thread only, after DISP_ScrollArea. Drawing is not
+  *         affected: lines are written where they are in the unscrolled band.
+  * @param  y : line of the band shown at its top; the lines after it
+  *             follow, wrapping round to the first line of the band
+  * @retval None
+  */
+void DISP_ScrollTo(uint16_t y)
+{
+    uint8_t args[2];
+    uint16_t line;
+
+    if (DISP_MADCTL & DISP_MY) {
+        /* The panel scans the band bottom up: the start address is the
+           RAM line of the last line shown, the one before y */
+        y = (y > disp_scroll_top) ? y - 1U : disp_scroll_top + disp_scroll_lines - 1U;
+    }
+    line = DISP_RamLine(y);
+    args[0] = (uint8_t)(line >> 8);
+    args[1] = (uint8_t)line;
+    DISP_Command(ST7735_VSCSAD, args, sizeof(args));
+}
+
+/**
+  * @brief  A tile is out.
+  * @param  hspi : SPI handle
+  * @retval None
+  */
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    if (hspi == &DISP_SPI) {
+        tx_semaphore_ceiling_put(&disp_sent, 1);
+    }
+}
+
+/**
+  * @brief  The tile is lost, but the frame carries on.
+  * @param  hspi : SPI handle
+  * @retval None
+  */
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)
+{
+    if (hspi == &DISP_SPI) {
+        tx_semaphore_ceiling_put(&disp_sent, 1);
+    }
+}
+
+static void DISP_Thread(ULONG thread_input)
+{
+    const uint8_t *p = disp_init;
+    uint8_t command, count, full;
+    ULONG start, busy, rest;
+    uint32_t i;
+
+    DISP_Reset();
+    while ((command = *p++) != ST7735_NOP) {
+        count = *p++;
+        DISP_Command(command, p, count & (uint8_t)~DISP_DELAY);
+        p += count & (uint8_t)~DISP_DELAY;
+        if (count & DISP_DELAY) {
+            tx_thread_sleep(*p++);
+        }
+    }
+
+    for (;;) {
+        tx_semaphore_get(&disp_dirty, TX_WAIT_FOREVER);
+        start = tx_time_get();
+        full  = disp_full;
+        disp_full = 0;
+
+        /* STOP1 would stop SPI1 mid-transfer */
+        LP_Hold();
+        if (full) {
+            DISP_Frame();
+        }
+        for (i = 0; i < DISP_MAX_UPDATES && disp_updates[i] != NULL; i++) {
+            disp_updates[i](full);
+        }
+        DISP_Wait();
+        LP_Release();
+
+        if (full && disp_frames++ == 0U) {
+            /* Only now, so that the contents of RAM at power-up never show */
+            DISP_Command(ST7735_DISPON, NULL, 0);
+        }
+
+        busy = tx_time_get() - start;
+        rest = (DISP_DUTY - 1U) * busy;
+        if (busy + rest < DISP_FRAME_TICKS) {
+            rest = DISP_FRAME_TICKS - busy;
+        }
+        tx_thread_sleep(rest);
+    }
+}
+
+static void DISP_Reset(void)
+{
+    HAL_GPIO_WritePin(LCD_RES_GPIO_Port, LCD_RES_Pin, GPIO_PIN_RESET);
+    tx_thread_sleep(10);
+    HAL_GPIO_WritePin(LCD_RES_GPIO_Port, LCD_RES_Pin, GPIO_PIN_SET);
+    tx_thread_sleep(120);
+}
+
+/* Polled, in 8-bit frames; LCD_RS is left high for data */
+static void DISP_Command(uint8_t command, const uint8_t *args, uint16_t count)
+{
+    DISP_Wait();
+    DISP_Wide(0);
+    HAL_GPIO_WritePin(LCD_RS_GPIO_Port, LCD_RS_Pin, GPIO_PIN_RESET);
+    (void)HAL_SPI_Transmit(&DISP_SPI, &command, 1, DISP_TIMEOUT);
+    HAL_GPIO_WritePin(LCD_RS_GPIO_Port, LCD_RS_Pin, GPIO_PIN_SET);
+    if (count != 0U) {
+        (void)HAL_SPI_Transmit(&DISP_SPI, (uint8_t *)args, count, DISP_TIMEOUT);
+    }
+}
+
+/* Set the drawing window and start a RAM write into it */
+static void DISP_Window(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1)
+{
+    uint8_t args[4];
+
+    x0 += DISP_X_OFFSET;
+    x1 += DISP_X_OFFSET;
+    y0 += DISP_Y_OFFSET;
+    y1 += DISP_Y_OFFSET;
+    args[0] = (uint8_t)(x0 >> 8);
+    args[1] = (uint8_t)x0;
+    args[2] = (uint8_t)(x1 >> 8);
+    args[3] = (uint8_t)x1;
+    DISP_Command(ST7735_CASET, args, sizeof(args));
+    args[0] = (uint8_t)(y0 >> 8);
+    args[1] = (uint8_t)y0;
+    args[2] = (uint8_t)(y1 >> 8);
+    args[3] = (uint8_t)y1;
+    DISP_Command(ST7735_RASET, args, sizeof(args));
+    DISP_Command(ST7735_RAMWR, NULL, 0);
+}
+
+/* The frame size can only change with the SPI disabled, HAL_SPI_Init does that */
+static void DISP_Wide(uint8_t wide)
+{
+    if (wide != disp_wide) {
+        disp_wide = wide;
+        DISP_SPI.Init.DataSize = wide ? SPI_DATASIZE_16BIT : SPI_DATASIZE_8BIT;
+        (void)HAL_SPI_Init(&DISP_SPI);
+    }
+}
+
+/* Until the last DMA transfer is out */
+static void DISP_Wait(void)
+{
+    if (tx_semaphore_get(&disp_sent, DISP_TIMEOUT) != TX_SUCCESS) {
+        (void)HAL_SPI_Abort(&DISP_SPI);
+    }
+    tx_semaphore_ceiling_put(&disp_sent, 1);
+}
+
+/* Pixels into the current window, in the background */
+static void DISP_Send(const uint16_t *pixels, uint16_t count)
+{
+    if (tx_semaphore_get(&disp_sent, DISP_TIMEOUT) != TX_SUCCESS) {
+        (void)HAL_SPI_Abort(&DISP_SPI);
+    }
+    DISP_Wide(1);
+    disp_sending = pixels;
+    if (HAL_SPI_Transmit_DMA(&DISP_SPI, (uint8_t *)pixels, count) != HAL_OK) {
+        tx_semaphore_ceiling_put(&disp_sent, 1);
+    }
+}
+
+/* Whole frame; each tile is rendered while the one before it goes out */
+static void DISP_Frame(void)
+{
+    uint16_t y, *tile;
+    uint32_t n = 0;
+
+    DISP_Window(0, 0, DISP_WIDTH - 1U, DISP_HEIGHT - 1U);
+    for (y = 0; y < DISP_HEIGHT; y += DISP_TILE_LINES) {
+        tile = disp_tiles[n++ & 1U];
+        disp_render(tile, y, DISP_TILE_LINES);
+        DISP_Send(tile, DISP_TILE_PIXELS);
+    }
+}
+
+/* Controller RAM line a panel line is written to */
+static uint16_t DISP_RamLine(uint16_t y)
+{
+    if (DISP_MADCTL & DISP_MY) {
+        return DISP_RAM_LINES - 1U - DISP_Y_OFFSET - y;
+    }
+    return DISP_Y_OFFSET + y;
+}
+
+static void DISP_Clear(uint16_t *pixels, uint16_t y, uint16_t lines)
+{
+    uint32_t i;
+
+    for (i = 0; i < (uint32_t)DISP_WIDTH * lines; i++) {
+        pixels[i] = DISP_BLACK;
+    }
+}
+
+#endif /* USE_DISPLAY */
@@ -0,0 +1,410 @@
+/**
+  ******************************************************************************
+  * @file    event.c
+  * @brief   Shock and transient capture.
+  *          Streaming every sample keeps the link busy when only impacts
+  *          matter. With a trigger mode selected, each block is checked
+  *          in the output thread, axis by axis: in level mode against a
+  *          baseline that follows the block means, in slope mode against
+  *          the sample before. The last EVENT_PRE_MAX frames are kept in
+  *          a ring; when a sample crosses its axis level, the history
+  *          before the trigger frame goes out as STREAM_TYPE_EVENT
+  *          records, followed by the frames after it as their blocks
+  *          come in, so no post-trigger buffer is needed. Between events
+  *          nothing is sent. With EVENT_MODE_OFF blocks pass on to the
+  *          streaming callback unchanged. See event.h for the layout.
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "event.h"
+#include "stream.h"
+
+#if (USE_EVENT)
+
+/* Private define ------------------------------------------------------------*/
+#define EVENT_AXES 3U
+
+#if (EVENT_PRE_MAX & (EVENT_PRE_MAX - 1U)) != 0U
+#error "EVENT_PRE_MAX must be a power of two"
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+static ACQ_CallbackTypeDef event_stream;
+static uint32_t event_mode;
+static uint16_t event_level[EVENT_AXES];
+static uint32_t event_pre;
+static uint32_t event_post;
+static uint32_t event_count;
+
+/* Frames before the current block, the newest at event_head - 1, and how
+   many of them are valid and not yet sent */
+static uint16_t event_ring[EVENT_PRE_MAX][EVENT_AXES];
+static uint32_t event_head;
+static uint32_t event_history;
+/* Set-up and block the ring continues with */
+static uint32_t event_generation;
+static uint32_t event_next_block;
+static uint8_t event_started;
+
+/* Level baseline, block means << EVENT_BASE_SHIFT, and the last sample
+   for the slope */
+static uint32_t event_base[EVENT_AXES];
+static uint16_t event_last[EVENT_AXES];
+
+/* Event being sent: frames still to go, and the offset of the next one */
+static uint32_t event_left;
+static int32_t event_offset;
+static uint32_t event_frames;
+static uint8_t event_payload[EVENT_HEADER_SIZE + EVENT_RECORD_FRAMES * STREAM_CHANNELS * 2U];
+
+/* Private function prototypes -----------------------------------------------*/
+static int32_t EVENT_Find(const ACQ_BlockTypeDef *block, uint8_t *axes);
+static void EVENT_Start(const ACQ_BlockTypeDef *block, uint32_t frame, uint8_t axes);
+static void EVENT_Put(const uint16_t *frame);
+static void EVENT_Flush(uint8_t flags);
+static void EVENT_Restart(void);
+
+static inline void EVENT_Put16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void EVENT_Put32(uint8_t *p, uint32_t v)
+{
+    EVENT_Put16(p, (uint16_t)v);
+    EVENT_Put16(p + 2, (uint16_t)(v >> 16));
+}
+
+/**
+  * @brief  Select EVENT_MODE, EVENT_LEVEL on every axis and the
+  *         EVENT_PRE / EVENT_POST window.
+  * @note   Call before ACQ_Init.
+  * @param  stream : callback the blocks go to with EVENT_MODE_OFF
+  * @retval None
+  */
+void EVENT_Init(ACQ_CallbackTypeDef stream)
+{
+    uint32_t axis;
+
+    event_stream = stream;
+    event_mode   = EVENT_MODE;
+    for (axis = 0; axis < EVENT_AXES; axis++) {
+        event_level[axis] = EVENT_LEVEL;
+    }
+    event_pre   = EVENT_PRE;
+    event_post  = EVENT_POST;
+    event_count = 0;
+    event_left  = 0;
+    EVENT_Restart();
+}
+
+/**
+  * @brief  Check a block for a trigger, keep it as history and send what
+  *         belongs to an event.
+  * @note   Matches ACQ_CallbackTypeDef. A gap in the block counter or a new
+  *         sampling set-up truncates the event and clears the history.
+  * @param  block : finished block
+  * @retval None
+  */
+void EVENT_Block(const ACQ_BlockTypeDef *block)
+{
+    const uint16_t *raw = (const uint16_t *)block->frames;
+    uint32_t mean[EVENT_AXES], sum, axis, i, from = ACQ_BLOCK_FRAMES;
+    int32_t trigger = -1;
+    uint8_t axes = 0, sending;
+
+    if (event_mode == EVENT_MODE_OFF) {
+        event_stream(block);
+        return;
+    }
+    if (event_started && (block->seq != event_next_block || block->config->generation != event_generation)) {
+        if (event_left != 0U) {
+            EVENT_Flush(EVENT_FLAG_LAST | EVENT_FLAG_TRUNCATED);
+        }
+        EVENT_Restart();
+    }
+    event_next_block = block->seq + 1U;
+    event_generation = block->config->generation;
+
+    for (axis = 0; axis < EVENT_AXES; axis++) {
+        sum = 0;
+        for (i = 0; i < ACQ_BLOCK_FRAMES; i++) {
+            sum += raw[i * ACQ_CHANNELS + axis];
+        }
+        mean[axis] = sum / ACQ_BLOCK_FRAMES;
+    }
+    if (!event_started) {
+        for (axis = 0; axis < EVENT_AXES; axis++) {
+            event_base[axis] = mean[axis] << EVENT_BASE_SHIFT;
+            event_last[axis] = raw[axis];
+        }
+        event_started = 1;
+    }
+
+    sending = (event_left != 0U);
+    if (sending) {
+        /* Frames after the trigger, until the window is full */
+        for (i = 0; i < ACQ_BLOCK_FRAMES && event_left != 0U; i++) {
+            EVENT_Put(&raw[i * ACQ_CHANNELS]);
+        }
+        from = i;
+    } else {
+        trigger = EVENT_Find(block, &axes);
+        if (trigger >= 0) {
+            EVENT_Start(block, (uint32_t)trigger, axes);
+            for (i = (uint32_t)trigger; i < ACQ_BLOCK_FRAMES && event_left != 0U; i++) {
+                EVENT_Put(&raw[i * ACQ_CHANNELS]);
+            }
+            from = i;
+        }
+    }
+
+    /* The baseline follows every block, a shock moves it by its share of
+       2^EVENT_BASE_SHIFT blocks; skipping the blocks that trigger would
+       bias it towards the quieter side */
+    for (axis = 0; axis < EVENT_AXES; axis++) {
+        event_base[axis] += mean[axis] - (event_base[axis] >> EVENT_BASE_SHIFT);
+    }
+
+    /* Keep the block as history; what an event has sent does not count */
+    for (i = 0; i < ACQ_BLOCK_FRAMES; i++) {
+        uint16_t *slot = event_ring[event_head++ % EVENT_PRE_MAX];
+
+        for (axis = 0; axis < EVENT_AXES; axis++) {
+            slot[axis] = raw[i * ACQ_CHANNELS + axis];
+        }
+    }
+    if (sending || trigger >= 0) {
+        event_history = (event_left != 0U) ? 0U : ACQ_BLOCK_FRAMES - from;
+    } else {
+        event_history += ACQ_BLOCK_FRAMES;
+    }
+    if (event_history > EVENT_PRE_MAX) {
+        event_history = EVENT_PRE_MAX;
+    }
+    for (axis = 0; axis < EVENT_AXES; axis++) {
+        event_last[axis] = raw[(ACQ_BLOCK_FRAMES - 1U) * ACQ_CHANNELS + axis];
+    }
+}
+
+/**
+  * @brief  Select the trigger mode, from the next block on.
+  * @note   Output thread only, as EVENT_Block. An event being sent is
+  *         truncated.
+  * @param  mode : EVENT_MODE_xxx
+  * @retval HAL_ERROR for an unknown mode
+  */
+HAL_StatusTypeDef EVENT_SetMode(uint32_t mode)
+{
+    if (mode >= EVENT_MODES) {
+        return HAL_ERROR;
+    }
+    if (event_left != 0U) {
+        EVENT_Flush(EVENT_FLAG_LAST | EVENT_FLAG_TRUNCATED);
+    }
+    event_mode = mode;
+    EVENT_Restart();
+    return HAL_OK;
+}
+
+/**
+  * @brief  Trigger mode in use.
+  * @retval EVENT_MODE_xxx
+  */
+uint32_t EVENT_GetMode(void)
+{
+    return event_mode;
+}
+
+/**
+  * @brief  Set the level of one axis.
+  * @note   Output thread only, as EVENT_Block.
+  * @param  axis : 0 x, 1 y, 2 z
+  * @param  level : ADC codes at the resolution in use, 0 disarms the axis
+  * @retval HAL_ERROR for an unknown axis or a level above 65535
+  */
+HAL_StatusTypeDef EVENT_SetLevel(uint32_t axis, uint32_t level)
+{
+    if (axis >= EVENT_AXES || level > 0xFFFFU) {
+        return HAL_ERROR;
+    }
+    event_level[axis] = (uint16_t)level;
+    return HAL_OK;
+}
+
+/**
+  * @brief  Level of one axis.
+  * @param  axis : 0 x, 1 y, 2 z
+  * @retval ADC codes, 0 when disarmed or for an unknown axis
+  */
+uint32_t EVENT_GetLevel(uint32_t axis)
+{
+    return (axis < EVENT_AXES) ? event_level[axis] : 0U;
+}
+
+/**
+  * @brief  Set the frames sent before the trigger, from the next event on.
+  * @note   Output thread only, as EVENT_Block.
+  * @param  pre : 0 to EVENT_PRE_MAX
+  * @retval HAL_ERROR above EVENT_PRE_MAX
+  */
+HAL_StatusTypeDef EVENT_SetPre(uint32_t pre)
+{
+    if (pre > EVENT_PRE_MAX) {
+        return HAL_ERROR;
+    }
+    event_pre = pre;
+    return HAL_OK;
+}
+
+/**
+  * @brief  Frames sent before the trigger.
+  * @retval Frames
+  */
+uint32_t EVENT_GetPre(void)
+{
+    return event_pre;
+}
+
+/**
+  * @brief  Set the frames sent from the trigger on, from the next event on.
+  * @note   Output thread only, as EVENT_Block.
+  * @param  post : 1 to EVENT_POST_MAX
+  * @retval HAL_ERROR out of range
+  */
+HAL_StatusTypeDef EVENT_SetPost(uint32_t post)
+{
+    if (post == 0U || post > EVENT_POST_MAX) {
+        return HAL_ERROR;
+    }
+    event_post = post;
+    return HAL_OK;
+}
+
+/**
+  * @brief  Frames sent from the trigger on.
+  * @retval Frames
+  */
+uint32_t EVENT_GetPost(void)
+{
+    return event_post;
+}
+
+/**
+  * @brief  Events triggered since start-up.
+  * @retval Count
+  */
+uint32_t EVENT_GetCount(void)
+{
+    return event_count;
+}
+
+/* First frame over its level on any armed axis, -1 for none; axes gets
+   the axes over at that frame */
+static int32_t EVENT_Find(const ACQ_BlockTypeDef *block, uint8_t *axes)
+{
+    const uint16_t *raw = (const uint16_t *)block->frames;
+    uint32_t axis, i;
+    int32_t ref, d, first = -1;
+
+    for (axis = 0; axis < EVENT_AXES; axis++) {
+        if (event_level[axis] == 0U) {
+            continue;
+        }
+        ref = (event_mode == EVENT_MODE_LEVEL) ? (int32_t)(event_base[axis] >> EVENT_BASE_SHIFT)
+                                               : (int32_t)event_last[axis];
+        for (i = 0; i < ACQ_BLOCK_FRAMES && (first < 0 || i <= (uint32_t)first); i++) {
+            d = (int32_t)raw[i * ACQ_CHANNELS + axis] - ref;
+            if (event_mode == EVENT_MODE_SLOPE) {
+                ref = raw[i * ACQ_CHANNELS + axis];
+            }
+            if (d < 0) {
+                d = -d;
+            }
+            if (d >= (int32_t)event_level[axis]) {
+                if (first < 0 || i < (uint32_t)first) {
+                    first = (int32_t)i;
+                    *axes = 0;
+                }
+                *axes |= (uint8_t)(1U << axis);
+                break;
+            }
+        }
+    }
+    return first;
+}
+
+/* Open an event at frame of block and send the history before it */
+static void EVENT_Start(const ACQ_BlockTypeDef *block, uint32_t frame, uint8_t axes)
+{
+    const uint16_t *raw = (const uint16_t *)block->frames;
+    uint32_t pre = event_pre, back, i;
+    uint64_t time = ACQ_GetTime(block);
+
+    if (pre > event_history + frame) {
+        pre = event_history + frame;
+    }
+    STREAM_Describe(block);
+    event_count++;
+    EVENT_Put32(&event_payload[0], block->stamp);
+    EVENT_Put32(&event_payload[4], block->seq);
+    EVENT_Put32(&event_payload[8], (uint32_t)time);
+    EVENT_Put32(&event_payload[12], (uint32_t)(time >> 32));
+    event_payload[16] = (uint8_t)frame;
+    event_payload[17] = axes;
+    EVENT_Put16(&event_payload[18], (uint16_t)event_count);
+    event_left   = pre + event_post;
+    event_offset = -(int32_t)pre;
+    event_frames = 0;
+
+    /* Oldest first: from the ring, then from the block */
+    back = (pre > frame) ? pre - frame : 0U;
+    for (i = back; i > 0U; i--) {
+        EVENT_Put(event_ring[(event_head - i) % EVENT_PRE_MAX]);
+    }
+    for (i = frame - (pre - back); i < frame; i++) {
+        EVENT_Put(&raw[i * ACQ_CHANNELS]);
+    }
+}
+
+/* Append a frame to the record, sending it when full or the event is done */
+static void EVENT_Put(const uint16_t *frame)
+{
+    uint8_t *out = &event_payload[EVENT_HEADER_SIZE + event_frames * STREAM_CHANNELS * 2U];
+    uint32_t axis;
+
+    for (axis = 0; axis < EVENT_AXES; axis++) {
+        EVENT_Put16(out + axis * 2U, frame[axis]);
+    }
+    event_frames++;
+    if (--event_left == 0U) {
+        EVENT_Flush(EVENT_FLAG_LAST);
+    } else if (event_frames == EVENT_RECORD_FRAMES) {
+        EVENT_Flush(0U);
+    }
+}
+
+/* Send the record, the frames in it so far */
+static void EVENT_Flush(uint8_t flags)
+{
+    EVENT_Put16(&event_payload[20], (uint16_t)event_offset);
+    event_payload[22] = (uint8_t)event_frames;
+    event_payload[23] = flags;
+    STREAM_Send(STREAM_TYPE_EVENT, event_payload,
+                (uint16_t)(EVENT_HEADER_SIZE + event_frames * STREAM_CHANNELS * 2U));
+    event_offset += (int32_t)event_frames;
+    event_frames  = 0;
+    if (flags & EVENT_FLAG_LAST) {
+        event_left = 0;
+    }
+}
+
+/* Forget the history and the baseline, the next block starts them afresh */
+static void EVENT_Restart(void)
+{
+    event_history = 0;
+    event_started = 0;
+}
+
+#endif /* USE_EVENT */
@@ -0,0 +1,263 @@
+/**
+  ******************************************************************************
+  * @file    latency.c
+  * @brief   Interrupt-to-thread latency of the acquisition path.
+  *          TIM1 triggers a frame of conversions every period and the DMA
+  *          interrupt fires when the last frame of a block is in; the
+  *          output thread consumes the block later. The DMA handler notes
+  *          the TIM1 count, which is the time since the last trigger in us,
+  *          and the core cycle clock, LP_Cycles. The output thread reads the
+  *          cycle clock again as it takes the block. Both stages, and their
+  *          sum, go into log-linear histograms with min, mean and max, that
+  *          LAT_Report sends on request. The histograms start afresh on
+  *          every change of the sampling set-up, which moves stage one.
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "latency.h"
+#include "tim.h"
+#include "stream.h"
+#include "lowpower.h"
+
+#if (USE_LATENCY)
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint16_t bins[LAT_BINS];
+} LAT_HistTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+static LAT_HistTypeDef lat_hist[LAT_STAGES];
+/* Set-up the histograms belong to */
+static uint32_t lat_generation;
+static uint32_t lat_period_us;
+static uint32_t lat_conv_us;
+/* Taken at the last DMA interrupt, copied into the block by LAT_Stamp */
+static uint32_t lat_irq_count;
+static uint32_t lat_irq_cycles;
+/* Kept off the output thread's stack */
+static uint8_t lat_payload[LAT_PAYLOAD_SIZE];
+
+/* Per mille points reported */
+static const uint16_t lat_points[] = { 500U, 900U, 990U, 999U };
+
+/* Private function prototypes -----------------------------------------------*/
+static void LAT_Clear(void);
+static void LAT_Add(LAT_HistTypeDef *hist, uint32_t us);
+static uint32_t LAT_Bin(uint32_t us);
+static uint32_t LAT_BinTop(uint32_t bin);
+static uint32_t LAT_Percentile(const LAT_HistTypeDef *hist, uint32_t permille);
+
+static inline void LAT_Put32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/**
+  * @brief  Empty the histograms.
+  * @retval None
+  */
+void LAT_Init(void)
+{
+    LAT_Clear();
+    lat_generation = 0;
+    lat_period_us  = 0;
+    lat_conv_us    = 0;
+}
+
+/**
+  * @brief  Note the time of the DMA interrupt.
+  * @note   DMA1 channel 1 handler only, through LAT_ISR_ENTER.
+  * @retval None
+  */
+void LAT_IsrEnter(void)
+{
+    lat_irq_count  = __HAL_TIM_GET_COUNTER(&htim1);
+    lat_irq_cycles = LP_Cycles();
+}
+
+/**
+  * @brief  Copy the time of the DMA interrupt into the block it delivers.
+  * @param  block : block being posted, from the same interrupt
+  * @retval None
+  */
+void LAT_Stamp(ACQ_BlockTypeDef *block)
+{
+    block->irq_count  = lat_irq_count;
+    block->irq_cycles = lat_irq_cycles;
+}
+
+/**
+  * @brief  Measure a block as the output thread takes it.
+  * @note   Output thread only, before anything else is done with the block.
+  * @param  block : stamped block
+  * @retval None
+  */
+void LAT_Record(const ACQ_BlockTypeDef *block)
+{
+    TX_INTERRUPT_SAVE_AREA
+    const ACQ_ConfigTypeDef *config = block->config;
+    uint32_t now, conv_us, irq_us, thread_us;
+
+    TX_DISABLE
+    now = LP_Cycles();
+    TX_RESTORE
+
+    conv_us = config->ratio * ACQ_FRAME_CYCLES / ACQ_ADC_MHZ;
+    if (config->generation != lat_generation) {
+        LAT_Clear();
+        lat_generation = config->generation;
+        lat_period_us  = config->period_us;
+        lat_conv_us    = conv_us;
+    }
+
+    /* The interrupt cannot come before the frame's conversions are done:
+       a count below that is from the next period, the trigger was missed */
+    irq_us = block->irq_count;
+    if (irq_us < conv_us) {
+        irq_us += config->period_us;
+    }
+    thread_us = (now - block->irq_cycles) / LP_CYCLES_PER_US;
+
+    LAT_Add(&lat_hist[LAT_STAGE_IRQ], irq_us);
+    LAT_Add(&lat_hist[LAT_STAGE_THREAD], thread_us);
+    LAT_Add(&lat_hist[LAT_STAGE_TOTAL], irq_us + thread_us);
+}
+
+/**
+  * @brief  Send one STREAM_TYPE_LATENCY packet per stage.
+  * @note   Output thread only, as for every stream packet.
+  * @param  clear : start the histograms afresh after sending
+  * @retval None
+  */
+void LAT_Report(uint8_t clear)
+{
+    const LAT_HistTypeDef *hist;
+    ULONG stamp = tx_time_get();
+    uint32_t stage, i, mean;
+    uint8_t *p;
+
+    for (stage = 0; stage < LAT_STAGES; stage++) {
+        hist = &lat_hist[stage];
+        mean = (hist->count != 0U) ? (uint32_t)(hist->sum / hist->count) : 0U;
+
+        memset(lat_payload, 0, LAT_HEADER_SIZE);
+        LAT_Put32(&lat_payload[0], stamp);
+        lat_payload[4] = (uint8_t)stage;
+        lat_payload[5] = (uint8_t)LAT_BINS;
+        LAT_Put32(&lat_payload[8], hist->count);
+        LAT_Put32(&lat_payload[12], hist->min);
+        LAT_Put32(&lat_payload[16], mean);
+        LAT_Put32(&lat_payload[20], hist->max);
+        for (i = 0; i < sizeof(lat_points) / sizeof(lat_points[0]); i++) {
+            LAT_Put32(&lat_payload[24 + 4 * i], LAT_Percentile(hist, lat_points[i]));
+        }
+        LAT_Put32(&lat_payload[40], lat_period_us);
+        LAT_Put32(&lat_payload[44], lat_conv_us);
+        p = &lat_payload[LAT_HEADER_SIZE];
+        for (i = 0; i < LAT_BINS; i++) {
+            *p++ = (uint8_t)hist->bins[i];
+            *p++ = (uint8_t)(hist->bins[i] >> 8);
+        }
+        STREAM_Send(STREAM_TYPE_LATENCY, lat_payload, sizeof(lat_payload));
+    }
+    if (clear) {
+        LAT_Clear();
+    }
+}
+
+/**
+  * @brief  Longest trigger-to-thread latency since the last clear.
+  * @retval us
+  */
+uint32_t LAT_Worst(void)
+{
+    return lat_hist[LAT_STAGE_TOTAL].max;
+}
+
+static void LAT_Clear(void)
+{
+    memset(lat_hist, 0, sizeof(lat_hist));
+}
+
+static void LAT_Add(LAT_HistTypeDef *hist, uint32_t us)
+{
+    uint32_t bin = LAT_Bin(us), i;
+
+    if (hist->count == 0U || us < hist->min) {
+        hist->min = us;
+    }
+    if (us > hist->max) {
+        hist->max = us;
+    }
+    hist->count++;
+    hist->sum += us;
+
+    if (hist->bins[bin] == 0xFFFFU) {
+        /* Halving every bin keeps the shape, and so the percentiles */
+        for (i = 0; i < LAT_BINS; i++) {
+            hist->bins[i] = (uint16_t)((hist->bins[i] + 1U) >> 1);
+        }
+    }
+    hist->bins[bin]++;
+}
+
+/* Exact below LAT_LINEAR_BINS, then LAT_OCTAVE_BINS per octave */
+static uint32_t LAT_Bin(uint32_t us)
+{
+    uint32_t octave = 0, bin;
+
+    if (us < LAT_LINEAR_BINS) {
+        return us;
+    }
+    while ((us >> octave) >= LAT_LINEAR_BINS) {
+        octave++;
+    }
+    /* us >> octave is 4 to 7 now */
+    bin = LAT_LINEAR_BINS + (octave - 1U) * LAT_OCTAVE_BINS + ((us >> octave) - LAT_OCTAVE_BINS);
+    return (bin < LAT_BINS) ? bin : (LAT_BINS - 1U);
+}
+
+/* Largest value that falls in a bin */
+static uint32_t LAT_BinTop(uint32_t bin)
+{
+    uint32_t octave, step;
+
+    if (bin < LAT_LINEAR_BINS) {
+        return bin;
+    }
+    octave = (bin - LAT_LINEAR_BINS) / LAT_OCTAVE_BINS + 1U;
+    step   = (bin - LAT_LINEAR_BINS) % LAT_OCTAVE_BINS + LAT_OCTAVE_BINS;
+    return ((step + 1U) << octave) - 1U;
+}
+
+static uint32_t LAT_Percentile(const LAT_HistTypeDef *hist, uint32_t permille)
+{
+    uint32_t total = 0, target, seen = 0, i, top;
+
+    for (i = 0; i < LAT_BINS; i++) {
+        total += hist->bins[i];
+    }
+    if (total == 0U) {
+        return 0;
+    }
+    target = (total * permille + 999U) / 1000U;
+    for (i = 0; i < LAT_BINS - 1U; i++) {
+        seen += hist->bins[i];
+        if (seen >= target) {
+            break;
+        }
+    }
+    top = LAT_BinTop(i);
+    return (top < hist->max) ? top : hist->max;
+}
+
+#endif /* USE_LATENCY */
@@ -0,0 +1,231 @@
+/**
+  ******************************************************************************
+  * @file    lowpower.c
+  * @brief   Tickless idle.
+  *          When the scheduler finds nothing ready it calls tx_low_power_enter
+  *          with interrupts masked. The kernel SysTick and the HAL TIM17 tick
+  *          are stopped and LPTIM1, clocked from LSE, is set to wake the core
+  *          on the tick the first armed ThreadX timer is due. Any other
+  *          interrupt ends the sleep early. tx_low_power_exit credits the
+  *          ticks that went by to the kernel and HAL clocks and restarts them.
+  *          The core enters STOP1 unless a module holds the high-speed clocks
+  *          with LP_Hold (running ADC/DMA, UART transfer), then plain Sleep.
+  *          A peripheral that must wake the core for input it cannot
+  *          predict needs a hold for as long as it listens, unless it is
+  *          a STOP1 wake-up source. USART2 is not one here: STOP1 stops
+  *          its RX DMA ring, and waking on the RX pin would still lose
+  *          the request that did it. The Modbus slave therefore holds for
+  *          good, which is why USE_MODBUS is off by default; a build with
+  *          it trades STOP1 for a slave that answers every request.
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "lowpower.h"
+#include "lptim.h"
+#include "tx_timer.h"
+
+/* Private variables ---------------------------------------------------------*/
+static volatile uint32_t lp_holds;
+static uint8_t  lp_tickless;    /* SysTick stopped by the last enter */
+static uint8_t  lp_deep;        /* last enter selected STOP1 */
+static uint8_t  lp_cmp_busy;    /* CMP write not yet synchronised to LPTIM */
+static uint16_t lp_start;       /* LPTIM count at enter */
+static ULONG    lp_ticks;       /* ticks to the first armed timer slot */
+static uint32_t lp_us;          /* time into the current tick at enter */
+static uint32_t lp_carry_us;    /* slept time not yet credited as a tick */
+
+volatile uint32_t lp_stop_entries;
+volatile uint32_t lp_sleep_entries;
+
+/* Private function prototypes -----------------------------------------------*/
+static ULONG LP_NextTimer(void);
+static void LP_Advance(ULONG ticks);
+static uint16_t LP_Count(void);
+
+/**
+  * @brief  Start LPTIM1 free-running with the compare-match interrupt enabled.
+  * @note   Call after MX_LPTIM1_Init, before the kernel starts.
+  * @retval None
+  */
+void LP_Init(void)
+{
+    /* IER is only writable with the timer disabled, ARR only with it enabled */
+    __HAL_LPTIM_ENABLE_IT(&hlptim1, LPTIM_IT_CMPM);
+    __HAL_LPTIM_ENABLE(&hlptim1);
+    __HAL_LPTIM_AUTORELOAD_SET(&hlptim1, 0xFFFFU);
+    while (!__HAL_LPTIM_GET_FLAG(&hlptim1, LPTIM_FLAG_ARROK)) {
+    }
+    __HAL_LPTIM_CLEAR_FLAG(&hlptim1, LPTIM_FLAG_ARROK);
+    __HAL_LPTIM_START_CONTINUOUS(&hlptim1);
+}
+
+/**
+  * @brief  Keep the high-speed clocks running through idle (Sleep, not STOP1).
+  * @note   Callable from threads and ISRs, nests.
+  * @retval None
+  */
+void LP_Hold(void)
+{
+    TX_INTERRUPT_SAVE_AREA
+
+    TX_DISABLE
+    lp_holds++;
+    TX_RESTORE
+}
+
+/**
+  * @brief  Drop a hold taken with LP_Hold.
+  * @retval None
+  */
+void LP_Release(void)
+{
+    TX_INTERRUPT_SAVE_AREA
+
+    TX_DISABLE
+    if (lp_holds != 0U) {
+        lp_holds--;
+    }
+    TX_RESTORE
+}
+
+/**
+  * @brief  Core clock cycles since start, from the kernel tick count and
+  *         the SysTick down-counter: the Cortex-M0+ has no cycle counter.
+  * @note   Call with interrupts disabled. Wraps every 67 s. Across a
+  *         tickless period it only advances by whole ticks.
+  * @retval Cycle count
+  */
+uint32_t LP_Cycles(void)
+{
+    uint32_t ticks = _tx_timer_system_clock;
+    uint32_t load  = SysTick->LOAD;
+    uint32_t val   = SysTick->VAL;
+
+    /* SysTick wrapped but its interrupt has not counted the tick yet */
+    if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) {
+        ticks++;
+        val = SysTick->VAL;
+    }
+    return ticks * (load + 1U) + (load - val);
+}
+
+/**
+  * @brief  Scheduler idle hook, interrupts are masked.
+  * @retval None
+  */
+void tx_low_power_enter(void)
+{
+    uint32_t counts;
+
+    lp_tickless = 0;
+    if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) {
+        return; /* a tick is already due */
+    }
+    lp_ticks = LP_NextTimer();
+    if (lp_ticks < LP_MIN_TICKS) {
+        return;
+    }
+
+    SysTick->CTRL &= ~(SysTick_CTRL_ENABLE_Msk | SysTick_CTRL_TICKINT_Msk);
+    lp_us = lp_carry_us + (SysTick->LOAD - SysTick->VAL) * 1000U / (SysTick->LOAD + 1U);
+    if (lp_us >= lp_ticks * 1000U) {
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk | SysTick_CTRL_TICKINT_Msk;
+        return;
+    }
+
+    /* Wake on the LPTIM count at or just after the due tick */
+    counts = ((lp_ticks * 1000U - lp_us) * LP_LPTIM_HZ + 999999U) / 1000000U;
+    while (lp_cmp_busy && !__HAL_LPTIM_GET_FLAG(&hlptim1, LPTIM_FLAG_CMPOK)) {
+    }
+    __HAL_LPTIM_CLEAR_FLAG(&hlptim1, LPTIM_FLAG_CMPOK);
+    lp_start = LP_Count();
+    __HAL_LPTIM_COMPARE_SET(&hlptim1, (uint16_t)(lp_start + counts));
+    lp_cmp_busy = 1;
+
+    HAL_SuspendTick();
+    if (lp_holds == 0U) {
+        MODIFY_REG(PWR->CR1, PWR_CR1_LPMS, PWR_LOWPOWERMODE_STOP1);
+        SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+        lp_deep = 1;
+        lp_stop_entries++;
+    } else {
+        lp_sleep_entries++;
+    }
+    lp_tickless = 1;
+}
+
+/**
+  * @brief  Scheduler wake-up hook, interrupts are still masked.
+  * @retval None
+  */
+void tx_low_power_exit(void)
+{
+    uint32_t us, ticks;
+
+    if (!lp_tickless) {
+        return;
+    }
+    lp_tickless = 0;
+    if (lp_deep) {
+        /* STOP1 leaves the core on HSI16 with the PLL off */
+        SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+        lp_deep = 0;
+        SystemClock_Config();
+    }
+
+    us    = lp_us + (uint32_t)(uint16_t)(LP_Count() - lp_start) * 15625U / 16U;
+    ticks = us / 1000U;
+    if (ticks >= lp_ticks) {
+        /* Let the SysTick handler run the due tick so the timer fires */
+        ticks = lp_ticks - 1U;
+        lp_carry_us = 0;
+        SCB->ICSR = SCB_ICSR_PENDSTSET_Msk;
+    } else {
+        lp_carry_us = us - ticks * 1000U;
+    }
+    LP_Advance(ticks);
+    uwTick += ticks;
+
+    SysTick->VAL   = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk | SysTick_CTRL_TICKINT_Msk;
+    HAL_ResumeTick();
+}
+
+/* Ticks until the timer interrupt reaches the first occupied wheel slot */
+static ULONG LP_NextTimer(void)
+{
+    TX_TIMER_INTERNAL **slot = _tx_timer_current_ptr;
+    ULONG ticks;
+
+    for (ticks = 1U; ticks <= TX_TIMER_ENTRIES; ticks++) {
+        if (*slot != TX_NULL) {
+            return ticks;
+        }
+        slot++;
+        if (slot == _tx_timer_list_end) {
+            slot = _tx_timer_list_start;
+        }
+    }
+    return LP_MAX_TICKS;
+}
+
+/* Replay ticks that would have found every slot empty */
+static void LP_Advance(ULONG ticks)
+{
+    ULONG index = (ULONG)(_tx_timer_current_ptr - _tx_timer_list_start);
+
+    _tx_timer_system_clock += ticks;
+    _tx_timer_current_ptr = _tx_timer_list_start + (index + ticks) % TX_TIMER_ENTRIES;
+}
+
+/* CNT runs on the LPTIM clock, read until two reads agree */
+static uint16_t LP_Count(void)
+{
+    uint32_t a, b;
+
+    do {
+        a = hlptim1.Instance->CNT;
+        b = hlptim1.Instance->CNT;
+    } while (a != b);
+    return (uint16_t)a;
+}
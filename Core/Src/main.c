@@ -20,7 +20,9 @@
 #include "app_threadx.h"
 #include "main.h"
 #include "adc.h"
+#include "crc.h"
 #include "dma.h"
+#include "lptim.h"
 #include "spi.h"
 #include "tim.h"
 #include "usart.h"
@@ -29,6 +31,8 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "arm_math.h"
+#include "lowpower.h"
+#include "prof.h"
 //#include "arm_const_stucts.h"
 //#include "stm32_dsp.h"
 //#include "table_fft.h"
@@ -52,7 +56,6 @@
 //float32_t Vibrate_Buf[VIBBufSize];
 //float32_t Vibrate_Out[VIBBufSize];
 //  uint16_t ADC_Out[128];
-uint16_t ADCs_Value[4];
 float data = 0;
 //#define  FFT_LENGTH        256        //FFT
 //#define  SAMPLE_FREQ       2000        //Ƶ
@@ -114,10 +117,17 @@ int main(void)
   MX_USART2_UART_Init();
   MX_SPI1_Init();
   MX_TIM2_Init();
+  MX_CRC_Init();
+  MX_LPTIM1_Init();
+  MX_TIM3_Init();
+  MX_TIM1_Init();
   /* USER CODE BEGIN 2 */
-    HAL_TIM_Base_Start_IT(&htim2);
-    HAL_TIM_PWM_Start(&htim2, TIM_CHANNEL_1);
-    HAL_ADC_Start_DMA(&hadc1, (uint32_t*)ADCs_Value, 4);
+    LP_Init();
+#ifdef TX_EXECUTION_PROFILE_ENABLE
+    PROF_Init();
+#endif
+    HAL_TIM_Base_Start(&htim2);
+    HAL_TIM_Base_Start(&htim1);
 
 
 //    while(1) {
@@ -175,10 +185,16 @@ void SystemClock_Config(void)
   */
   HAL_PWREx_ControlVoltageScaling(PWR_REGULATOR_VOLTAGE_SCALE1);
 
+  /** Configure LSE Drive Capability
+  */
+  HAL_PWR_EnableBkUpAccess();
+  __HAL_RCC_LSEDRIVE_CONFIG(RCC_LSEDRIVE_LOW);
+
   /** Initializes the RCC Oscillators according to the specified parameters
   * in the RCC_OscInitTypeDef structure.
   */
-  RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_HSI;
+  RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_HSI|RCC_OSCILLATORTYPE_LSE;
+  RCC_OscInitStruct.LSEState = RCC_LSE_ON;
   RCC_OscInitStruct.HSIState = RCC_HSI_ON;
   RCC_OscInitStruct.HSIDiv = RCC_HSI_DIV1;
   RCC_OscInitStruct.HSICalibrationValue = RCC_HSICALIBRATION_DEFAULT;
@@ -223,11 +239,7 @@ void SystemClock_Config(void)
 void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
 {
   /* USER CODE BEGIN Callback 0 */
-    int TempX=ADCs_Value[0],TempY=ADCs_Value[1],TempZ=ADCs_Value[2];
-            printf("%c%c%c%c%c%c",
-               (TempX +4096) >> 8, TempX & 0xFF,
-               (TempY )>> 8, TempY & 0xFF,
-               (TempZ )>> 8, TempZ & 0xFF);
+
   /* USER CODE END Callback 0 */
   if (htim->Instance == TIM17) {
     HAL_IncTick();
@@ -0,0 +1,769 @@
+/**
+  ******************************************************************************
+  * @file    modbus.c
+  * @brief   Modbus RTU slave.
+  *          USART2 receives into a circular DMA ring without any per-byte
+  *          interrupt. It has no receiver timeout on the G031, so the end of
+  *          a frame takes two steps: the idle-line interrupt, one character
+  *          after the last, notes the ring index and sets TIM2 channel 2 to
+  *          compare at the rest of the 3.5 characters. If nothing has come
+  *          in by then, the compare handler takes the bytes the DMA has
+  *          written since the last frame and queues their position for the
+  *          Modbus thread, which checks the CRC, serves the request and
+  *          builds the answer over it; the TX DMA sends it from there and
+  *          the thread waits for the last bit to leave. The USART drives the
+  *          transceiver's DE line on PA1 itself, see MX_USART2_UART_Init.
+  *          A write is checked in full, then made by the output thread as
+  *          one job, so it never races a block being consumed; the answer
+  *          waits for that job and reports a setting that failed.
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "modbus.h"
+#include "acq.h"
+#include "cond.h"
+#include "cal.h"
+#include "defer.h"
+#include "event.h"
+#include "prof.h"
+#include "spectrum.h"
+#include "stackmon.h"
+#include "stats.h"
+#include "stream.h"
+#include "trace.h"
+#include "latency.h"
+#include "lowpower.h"
+#include "tim.h"
+
+#if (USE_MODBUS)
+
+/* Private define ------------------------------------------------------------*/
+#define MODBUS_UART huart2
+/* Free-running 1 MHz, channel 2 times the rest of the 3.5 characters */
+#define MODBUS_TIM  htim2
+
+#define MODBUS_FC_READ_HOLDING   0x03U
+#define MODBUS_FC_READ_INPUT     0x04U
+#define MODBUS_FC_WRITE_SINGLE   0x06U
+#define MODBUS_FC_WRITE_MULTIPLE 0x10U
+
+#define MODBUS_EX_ILLEGAL_FUNCTION 0x01U
+#define MODBUS_EX_ILLEGAL_ADDRESS  0x02U
+#define MODBUS_EX_ILLEGAL_VALUE    0x03U
+#define MODBUS_EX_DEVICE_FAILURE   0x04U
+#define MODBUS_EX_BUSY             0x06U
+
+/* Registers per read and per write multiple request */
+#define MODBUS_READ_MAX  125U
+#define MODBUS_WRITE_MAX 123U
+/* Address, function and CRC */
+#define MODBUS_ADU_MIN   4U
+
+/* Private variables ---------------------------------------------------------*/
+/* CRC-16/MODBUS, reflected polynomial 0xA001, one byte per lookup */
+static const uint16_t modbus_crc_table[256] = {
+    0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
+    0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
+    0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
+    0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841,
+    0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40,
+    0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41,
+    0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641,
+    0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040,
+    0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240,
+    0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441,
+    0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41,
+    0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840,
+    0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41,
+    0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40,
+    0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640,
+    0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041,
+    0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240,
+    0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441,
+    0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41,
+    0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840,
+    0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41,
+    0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40,
+    0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640,
+    0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041,
+    0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241,
+    0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440,
+    0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40,
+    0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841,
+    0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
+    0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
+    0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
+    0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040
+};
+
+static TX_THREAD modbus_thread;
+static uint8_t modbus_thread_stack[MODBUS_STACK_SIZE];
+static TX_QUEUE modbus_queue;
+static ULONG modbus_queue_storage[MODBUS_QUEUE_DEPTH];
+/* Put once the answer has left, modbus_adu is free again, or once the
+   output thread has made a write */
+static TX_SEMAPHORE modbus_done;
+static uint8_t modbus_rx[MODBUS_RX_SIZE];
+/* Request copied out of the ring, then the answer built in place */
+static uint8_t modbus_adu[MODBUS_ADU_SIZE];
+/* Ring index the next frame starts at */
+static volatile uint16_t modbus_rx_head;
+/* Ring index at the last idle line, the frame ends there if it still is */
+static volatile uint16_t modbus_rx_idle;
+/* 3.5 characters less the one the idle line takes, us */
+static uint32_t modbus_t35_us;
+/* Write handed to the output thread, the values stay in modbus_adu */
+static uint16_t modbus_write_addr;
+static const uint8_t *modbus_write_values;
+static uint8_t modbus_write_ex;
+/* Set while answering, anything received meanwhile is our own echo */
+static volatile uint8_t modbus_tx_busy;
+
+volatile uint32_t modbus_frames;
+volatile uint32_t modbus_crc_errors;
+volatile uint32_t modbus_lost;
+
+/* Private function prototypes -----------------------------------------------*/
+static void MODBUS_Thread(ULONG thread_input);
+static HAL_StatusTypeDef MODBUS_StartRx(void);
+static uint16_t MODBUS_RxIndex(void);
+static void MODBUS_Send(uint16_t len);
+static uint16_t MODBUS_Crc(const uint8_t *data, uint16_t len);
+static uint16_t MODBUS_Process(uint8_t *adu, uint16_t len);
+static uint8_t MODBUS_ReadHolding(uint16_t reg, uint16_t *value);
+static uint8_t MODBUS_ReadInput(uint16_t reg, uint16_t *value);
+static uint8_t MODBUS_Write(uint16_t addr, uint16_t count, const uint8_t *values);
+static void MODBUS_ApplyWrite(ULONG count, ULONG stamp);
+static uint8_t MODBUS_WriteHolding(uint16_t reg, uint16_t value, uint8_t apply);
+#if (USE_STATS)
+static uint16_t MODBUS_ReadStats(uint16_t n);
+#endif
+
+static inline uint16_t MODBUS_Get16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static inline void MODBUS_Put16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+/**
+  * @brief  Create the Modbus thread and start listening on USART2.
+  * @note   Must run from tx_application_define, after DEFER_Init. Holds
+  *         the high-speed clocks for good: the core only ever Sleeps.
+  * @retval ThreadX status
+  */
+UINT MODBUS_Init(void)
+{
+    UINT status;
+
+    modbus_frames     = 0;
+    modbus_crc_errors = 0;
+    modbus_lost       = 0;
+    modbus_tx_busy    = 0;
+    modbus_t35_us     = (MODBUS_T35_BITS - MODBUS_IDLE_BITS) * 1000000UL / MODBUS_UART.Init.BaudRate + 1U;
+
+    status = tx_queue_create(&modbus_queue, "modbus queue", 1, modbus_queue_storage, sizeof(modbus_queue_storage));
+    if (status == TX_SUCCESS) {
+        status = tx_semaphore_create(&modbus_done, "modbus done", 0);
+    }
+    if (status != TX_SUCCESS) {
+        return status;
+    }
+
+    if (MODBUS_StartRx() != HAL_OK) {
+        return TX_NOT_AVAILABLE;
+    }
+    /* STOP1 stops the USART2 clock and its RX DMA ring, and the slave
+       has to hear a request at any time, RUN=1 included */
+    LP_Hold();
+    return tx_thread_create(&modbus_thread, "modbus thread", MODBUS_Thread, 0,
+                            modbus_thread_stack, MODBUS_STACK_SIZE,
+                            MODBUS_PRIORITY, MODBUS_PRIORITY, TX_NO_TIME_SLICE, TX_AUTO_START);
+}
+
+/**
+  * @brief  Idle line, call first thing in USART2_IRQHandler: start the
+  *         t3.5 check on TIM2. Also notes the end of an answer, which
+  *         HAL_UART_IRQHandler then completes.
+  * @note   Also clears the error flags, whose interrupt is off: a damaged
+  *         character fails the CRC, and the DMA ring runs on regardless.
+  * @param  huart : UART handle
+  * @retval None
+  */
+void MODBUS_UART_IRQHandler(UART_HandleTypeDef *huart)
+{
+    if (huart != &MODBUS_UART) {
+        return;
+    }
+    if (modbus_tx_busy && __HAL_UART_GET_FLAG(huart, UART_FLAG_TC) != RESET &&
+        __HAL_UART_GET_IT_SOURCE(huart, UART_IT_TC) != RESET) {
+        /* Last stop bit out: skip whatever echo came in meanwhile */
+        modbus_rx_head = MODBUS_RxIndex();
+        modbus_tx_busy = 0;
+        tx_semaphore_ceiling_put(&modbus_done, 1);
+    }
+    if (__HAL_UART_GET_FLAG(huart, UART_FLAG_IDLE) == RESET) {
+        return;
+    }
+    __HAL_UART_CLEAR_FLAG(huart, UART_CLEAR_IDLEF | UART_CLEAR_PEF | UART_CLEAR_FEF |
+                                 UART_CLEAR_NEF | UART_CLEAR_OREF);
+
+    modbus_rx_idle = MODBUS_RxIndex();
+    __HAL_TIM_SET_COMPARE(&MODBUS_TIM, TIM_CHANNEL_2, __HAL_TIM_GET_COUNTER(&MODBUS_TIM) + modbus_t35_us);
+    __HAL_TIM_CLEAR_FLAG(&MODBUS_TIM, TIM_FLAG_CC2);
+    __HAL_TIM_ENABLE_IT(&MODBUS_TIM, TIM_IT_CC2);
+}
+
+/**
+  * @brief  End-of-frame detection, call first thing in TIM2_IRQHandler.
+  * @note   A character received since the idle line means the frame goes
+  *         on; its own idle line starts the check again.
+  * @param  htim : TIM handle
+  * @retval None
+  */
+void MODBUS_TIM_IRQHandler(TIM_HandleTypeDef *htim)
+{
+    uint16_t end, len;
+    ULONG frame;
+
+    if (htim != &MODBUS_TIM || __HAL_TIM_GET_FLAG(htim, TIM_FLAG_CC2) == RESET ||
+        __HAL_TIM_GET_IT_SOURCE(htim, TIM_IT_CC2) == RESET) {
+        return;
+    }
+    __HAL_TIM_CLEAR_FLAG(htim, TIM_FLAG_CC2);
+    __HAL_TIM_DISABLE_IT(htim, TIM_IT_CC2);
+
+    end = MODBUS_RxIndex();
+    if (end != modbus_rx_idle) {
+        return;
+    }
+    len = (uint16_t)(end - modbus_rx_head);
+    if (end < modbus_rx_head) {
+        len = (uint16_t)(len + MODBUS_RX_SIZE);
+    }
+    frame = modbus_rx_head | ((ULONG)len << 16);
+    modbus_rx_head = end;
+    if (len == 0U || modbus_tx_busy) {
+        return;
+    }
+    if (tx_queue_send(&modbus_queue, &frame, TX_NO_WAIT) != TX_SUCCESS) {
+        modbus_lost++;
+    }
+}
+
+/**
+  * @brief  Receive side of HAL_UART_ErrorCallback. Only a DMA error gets
+  *         here; HAL has already aborted the reception, so start again
+  *         from the top of the ring.
+  * @param  huart : UART handle
+  * @retval None
+  */
+void MODBUS_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    if (huart == &MODBUS_UART) {
+        MODBUS_StartRx();
+    }
+}
+
+static HAL_StatusTypeDef MODBUS_StartRx(void)
+{
+    modbus_rx_head = 0;
+    if (HAL_UART_Receive_DMA(&MODBUS_UART, modbus_rx, MODBUS_RX_SIZE) != HAL_OK) {
+        return HAL_ERROR;
+    }
+    /* Framing, noise and overrun errors would make HAL abort the ring */
+    __HAL_UART_DISABLE_IT(&MODBUS_UART, UART_IT_ERR);
+    __HAL_UART_DISABLE_IT(&MODBUS_UART, UART_IT_PE);
+    __HAL_UART_CLEAR_FLAG(&MODBUS_UART, UART_CLEAR_IDLEF);
+    __HAL_UART_ENABLE_IT(&MODBUS_UART, UART_IT_IDLE);
+    return HAL_OK;
+}
+
+/* Ring index the DMA writes next; CNDTR counts down from the size and
+   reloads after the last byte */
+static uint16_t MODBUS_RxIndex(void)
+{
+    return (uint16_t)(MODBUS_RX_SIZE - __HAL_DMA_GET_COUNTER(MODBUS_UART.hdmarx));
+}
+
+/* Send modbus_adu[0, len) and wait until it is on the wire */
+static void MODBUS_Send(uint16_t len)
+{
+    modbus_tx_busy = 1;
+    if (HAL_UART_Transmit_DMA(&MODBUS_UART, modbus_adu, len) != HAL_OK) {
+        modbus_tx_busy = 0;
+        return;
+    }
+    if (tx_semaphore_get(&modbus_done, MODBUS_TX_TIMEOUT) != TX_SUCCESS) {
+        /* Never completed: stop the DMA before the buffer is reused */
+        HAL_UART_AbortTransmit(&MODBUS_UART);
+        modbus_rx_head = MODBUS_RxIndex();
+        modbus_tx_busy = 0;
+    }
+}
+
+static void MODBUS_Thread(ULONG thread_input)
+{
+    ULONG frame;
+    uint16_t pos, len, i, crc;
+
+    for (;;) {
+        tx_queue_receive(&modbus_queue, &frame, TX_WAIT_FOREVER);
+        pos = (uint16_t)frame;
+        len = (uint16_t)(frame >> 16);
+        if (len > MODBUS_ADU_SIZE) {
+            modbus_crc_errors++;
+            continue;
+        }
+        for (i = 0; i < len; i++) {
+            modbus_adu[i] = modbus_rx[pos];
+            if (++pos == MODBUS_RX_SIZE) {
+                pos = 0;
+            }
+        }
+        /* Over the whole frame, CRC included, a good CRC leaves 0 */
+        if (len < MODBUS_ADU_MIN || MODBUS_Crc(modbus_adu, len) != 0U) {
+            modbus_crc_errors++;
+            continue;
+        }
+        if (modbus_adu[0] != MODBUS_ADDRESS && modbus_adu[0] != MODBUS_BROADCAST) {
+            continue;
+        }
+        modbus_frames++;
+
+        len = MODBUS_Process(modbus_adu, (uint16_t)(len - 2U));
+        if (modbus_adu[0] == MODBUS_BROADCAST) {
+            continue;
+        }
+        crc = MODBUS_Crc(modbus_adu, len);
+        modbus_adu[len++] = (uint8_t)crc;
+        modbus_adu[len++] = (uint8_t)(crc >> 8);
+        MODBUS_Send(len);
+    }
+}
+
+static uint16_t MODBUS_Crc(const uint8_t *data, uint16_t len)
+{
+    uint16_t crc = 0xFFFFU;
+
+    while (len--) {
+        crc = (uint16_t)((crc >> 8) ^ modbus_crc_table[(uint8_t)(crc ^ *data++)]);
+    }
+    return crc;
+}
+
+/* Serve the request in adu[0, len) and build the answer over it.
+   Returns the answer length, CRC excluded */
+static uint16_t MODBUS_Process(uint8_t *adu, uint16_t len)
+{
+    uint16_t addr  = MODBUS_Get16(&adu[2]);
+    uint16_t count = MODBUS_Get16(&adu[4]);
+    uint16_t i, value = 0;
+    uint8_t ex = 0;
+
+    switch (adu[1]) {
+    case MODBUS_FC_READ_HOLDING:
+    case MODBUS_FC_READ_INPUT:
+        if (len != 6U || count == 0U || count > MODBUS_READ_MAX) {
+            ex = MODBUS_EX_ILLEGAL_VALUE;
+            break;
+        }
+        if ((uint32_t)addr + count > 0x10000UL) {
+            ex = MODBUS_EX_ILLEGAL_ADDRESS;
+            break;
+        }
+        /* The values overwrite the request from byte 3 on */
+        for (i = 0; i < count && ex == 0U; i++) {
+            if (adu[1] == MODBUS_FC_READ_HOLDING) {
+                ex = MODBUS_ReadHolding((uint16_t)(addr + i), &value);
+            } else {
+                ex = MODBUS_ReadInput((uint16_t)(addr + i), &value);
+            }
+            MODBUS_Put16(&adu[3U + 2U * i], value);
+        }
+        if (ex == 0U) {
+            adu[2] = (uint8_t)(2U * count);
+            return (uint16_t)(3U + 2U * count);
+        }
+        break;
+
+    case MODBUS_FC_WRITE_SINGLE:
+        if (len != 6U) {
+            ex = MODBUS_EX_ILLEGAL_VALUE;
+            break;
+        }
+        ex = MODBUS_Write(addr, 1U, &adu[4]);
+        if (ex == 0U) {
+            return 6U; /* echo of the request */
+        }
+        break;
+
+    case MODBUS_FC_WRITE_MULTIPLE:
+        if (len < 7U || count == 0U || count > MODBUS_WRITE_MAX ||
+            adu[6] != 2U * count || len != 7U + adu[6]) {
+            ex = MODBUS_EX_ILLEGAL_VALUE;
+            break;
+        }
+        if ((uint32_t)addr + count > 0x10000UL) {
+            ex = MODBUS_EX_ILLEGAL_ADDRESS;
+            break;
+        }
+        ex = MODBUS_Write(addr, count, &adu[7]);
+        if (ex == 0U) {
+            return 6U; /* address and count */
+        }
+        break;
+
+    default:
+        ex = MODBUS_EX_ILLEGAL_FUNCTION;
+        break;
+    }
+    adu[1] |= 0x80U;
+    adu[2]  = ex;
+    return 3U;
+}
+
+static uint8_t MODBUS_ReadHolding(uint16_t reg, uint16_t *value)
+{
+    switch (reg) {
+    case MODBUS_HR_OVERSAMPLING:
+        *value = ACQ_GetConfig()->ratio;
+        break;
+    case MODBUS_HR_RUN:
+        *value = ACQ_IsRunning();
+        break;
+#ifdef TX_EXECUTION_PROFILE_ENABLE
+    case MODBUS_HR_PROFILE:
+        *value = 0;
+        break;
+#endif
+#ifdef TX_ENABLE_STACK_CHECKING
+    case MODBUS_HR_STACKS:
+        *value = 0;
+        break;
+#endif
+#if (USE_LATENCY)
+    case MODBUS_HR_LATENCY:
+        *value = 0;
+        break;
+#endif
+#if (USE_COND)
+    case MODBUS_HR_COND_PRESET:
+        *value = (uint16_t)COND_GetPreset();
+        break;
+    case MODBUS_HR_COND_DC:
+        *value = (uint16_t)COND_GetDcShift();
+        break;
+#endif
+#if (USE_EVENT)
+    case MODBUS_HR_EVENT_MODE:
+        *value = (uint16_t)EVENT_GetMode();
+        break;
+    case MODBUS_HR_EVENT_LEVEL:
+    case MODBUS_HR_EVENT_LEVEL + 1U:
+    case MODBUS_HR_EVENT_LEVEL + 2U:
+        *value = (uint16_t)EVENT_GetLevel(reg - MODBUS_HR_EVENT_LEVEL);
+        break;
+    case MODBUS_HR_EVENT_PRE:
+        *value = (uint16_t)EVENT_GetPre();
+        break;
+    case MODBUS_HR_EVENT_POST:
+        *value = (uint16_t)EVENT_GetPost();
+        break;
+#endif
+#if (USE_STATS)
+    case MODBUS_HR_STATS_MODE:
+        *value = (uint16_t)STATS_GetMode();
+        break;
+    case MODBUS_HR_STATS_WINDOW:
+        *value = (uint16_t)STATS_GetWindow();
+        break;
+#endif
+    case MODBUS_HR_FORMAT:
+        *value = (uint16_t)STREAM_GetFormat();
+        break;
+    case MODBUS_HR_AXES:
+        *value = (uint16_t)STREAM_GetAxes();
+        break;
+    default:
+        return MODBUS_EX_ILLEGAL_ADDRESS;
+    }
+    return 0U;
+}
+
+static uint8_t MODBUS_ReadInput(uint16_t reg, uint16_t *value)
+{
+    const ACQ_ConfigTypeDef *config = ACQ_GetConfig();
+    uint32_t v;
+
+    switch (reg) {
+    case MODBUS_IR_PERIOD_HI:   v = config->period_us >> 16;        break;
+    case MODBUS_IR_PERIOD_LO:   v = config->period_us;              break;
+    case MODBUS_IR_RATE:        v = 1000000UL / config->period_us;  break;
+    case MODBUS_IR_RATIO:       v = config->ratio;                  break;
+    case MODBUS_IR_BITS:        v = config->bits;                   break;
+    case MODBUS_IR_OVERRUNS_HI: v = acq_overruns >> 16;             break;
+    case MODBUS_IR_OVERRUNS_LO: v = acq_overruns;                   break;
+    case MODBUS_IR_DROPPED_HI:  v = defer_dropped >> 16;            break;
+    case MODBUS_IR_DROPPED_LO:  v = defer_dropped;                  break;
+    case MODBUS_IR_TICKS_HI:    v = tx_time_get() >> 16;            break;
+    case MODBUS_IR_TICKS_LO:    v = tx_time_get();                  break;
+    case MODBUS_IR_FRAMES:      v = modbus_frames;                  break;
+    case MODBUS_IR_CRC_ERRORS:  v = modbus_crc_errors;              break;
+    case MODBUS_IR_LOST:        v = modbus_lost;                    break;
+#ifdef TX_ENABLE_STACK_CHECKING
+    case MODBUS_IR_OVERFLOWS:   v = stackmon_overflows;             break;
+#endif
+#ifdef TX_ENABLE_EVENT_TRACE
+    case MODBUS_IR_TRACE_LOST:  v = trace_lost;                     break;
+#endif
+#if (USE_LATENCY)
+    case MODBUS_IR_LATENCY_MAX:
+        v = LAT_Worst();
+        if (v > 0xFFFFU) {
+            v = 0xFFFFU;
+        }
+        break;
+#endif
+#if (USE_COND)
+    case MODBUS_IR_COND_RATE:
+        v = 1000000UL / config->period_us / COND_GetDecimation();
+        break;
+#endif
+#if (USE_CAL)
+    case MODBUS_IR_VDDA:        v = CAL_GetVdda();                  break;
+#endif
+#if (USE_EVENT)
+    case MODBUS_IR_EVENTS:      v = EVENT_GetCount();               break;
+#endif
+    default:
+#if (USE_SPECTRUM && SPECTRUM_PEAKS)
+        if (reg >= MODBUS_IR_PEAKS && reg < MODBUS_IR_PEAKS + SPECTRUM_AXES * SPECTRUM_PEAKS * 2U) {
+            uint16_t n = (uint16_t)(reg - MODBUS_IR_PEAKS), mag;
+            uint8_t bin = SPECTRUM_GetPeak(n / (2U * SPECTRUM_PEAKS), (n / 2U) % SPECTRUM_PEAKS, &mag);
+
+            *value = (n & 1U) ? mag : bin;
+            return 0U;
+        }
+#endif
+#if (USE_STATS)
+        if (reg >= MODBUS_IR_STATS && reg < MODBUS_IR_STATS + STATS_AXES * MODBUS_IR_STATS_AXIS) {
+            *value = MODBUS_ReadStats((uint16_t)(reg - MODBUS_IR_STATS));
+            return 0U;
+        }
+#endif
+        return MODBUS_EX_ILLEGAL_ADDRESS;
+    }
+    *value = (uint16_t)v;
+    return 0U;
+}
+
+/* Check every register of a write, then hand them all to the output
+   thread as one job and answer with its outcome */
+static uint8_t MODBUS_Write(uint16_t addr, uint16_t count, const uint8_t *values)
+{
+    uint16_t i;
+    uint8_t ex = 0;
+
+    for (i = 0; i < count && ex == 0U; i++) {
+        ex = MODBUS_WriteHolding((uint16_t)(addr + i), MODBUS_Get16(&values[2U * i]), 0U);
+    }
+    if (ex != 0U) {
+        return ex;
+    }
+    modbus_write_addr   = addr;
+    modbus_write_values = values;
+    if (DEFER_Post(MODBUS_ApplyWrite, count) != TX_SUCCESS) {
+        return MODBUS_EX_BUSY;
+    }
+    /* A queued job always runs; the values stay put in modbus_adu */
+    tx_semaphore_get(&modbus_done, TX_WAIT_FOREVER);
+    return modbus_write_ex;
+}
+
+/* Output thread side of a write, stops at the first register that fails */
+static void MODBUS_ApplyWrite(ULONG count, ULONG stamp)
+{
+    uint16_t i;
+    uint8_t ex = 0;
+
+    for (i = 0; i < count && ex == 0U; i++) {
+        ex = MODBUS_WriteHolding((uint16_t)(modbus_write_addr + i),
+                                 MODBUS_Get16(&modbus_write_values[2U * i]), 1U);
+    }
+    modbus_write_ex = ex;
+    tx_semaphore_ceiling_put(&modbus_done, 1);
+}
+
+/* Check a holding register write, and make it when apply is set; only
+   the output thread applies, so no block is consumed meanwhile */
+static uint8_t MODBUS_WriteHolding(uint16_t reg, uint16_t value, uint8_t apply)
+{
+    HAL_StatusTypeDef status = HAL_OK;
+
+    switch (reg) {
+    case MODBUS_HR_OVERSAMPLING:
+        if (value == 0U || value > ACQ_OVS_MAX || (value & (value - 1U)) != 0U) {
+            return MODBUS_EX_ILLEGAL_VALUE;
+        }
+        if (apply) {
+            status = ACQ_SetOversampling(value);
+        }
+        break;
+    case MODBUS_HR_RUN:
+        if (value > 1U) {
+            return MODBUS_EX_ILLEGAL_VALUE;
+        }
+        if (apply && value == 0U) {
+            status = ACQ_Stop();
+        } else if (apply && !ACQ_IsRunning()) {
+            status = ACQ_Start();
+        }
+        break;
+#ifdef TX_EXECUTION_PROFILE_ENABLE
+    case MODBUS_HR_PROFILE:
+        if (value != 1U) {
+            return MODBUS_EX_ILLEGAL_VALUE;
+        }
+        if (apply) {
+            PROF_Report();
+        }
+        break;
+#endif
+#ifdef TX_ENABLE_STACK_CHECKING
+    case MODBUS_HR_STACKS:
+        if (value != 1U) {
+            return MODBUS_EX_ILLEGAL_VALUE;
+        }
+        if (apply) {
+            STACKMON_Report();
+        }
+        break;
+#endif
+#if (USE_LATENCY)
+    case MODBUS_HR_LATENCY:
+        if (value == 0U || value > 2U) {
+            return MODBUS_EX_ILLEGAL_VALUE;
+        }
+        if (apply) {
+            LAT_Report(value == 2U);
+        }
+        break;
+#endif
+#if (USE_COND)
+    case MODBUS_HR_COND_PRESET:
+        if (value >= COND_PRESETS) {
+            return MODBUS_EX_ILLEGAL_VALUE;
+        }
+        if (apply) {
+            status = COND_SetPreset(value);
+        }
+        break;
+    case MODBUS_HR_COND_DC:
+        if (value > COND_DC_SHIFT_MAX) {
+            return MODBUS_EX_ILLEGAL_VALUE;
+        }
+        if (apply) {
+            status = COND_SetDcShift(value);
+        }
+        break;
+#endif
+#if (USE_EVENT)
+    case MODBUS_HR_EVENT_MODE:
+        if (value >= EVENT_MODES) {
+            return MODBUS_EX_ILLEGAL_VALUE;
+        }
+        if (apply) {
+            status = EVENT_SetMode(value);
+        }
+        break;
+    case MODBUS_HR_EVENT_LEVEL:
+    case MODBUS_HR_EVENT_LEVEL + 1U:
+    case MODBUS_HR_EVENT_LEVEL + 2U:
+        if (apply) {
+            status = EVENT_SetLevel(reg - MODBUS_HR_EVENT_LEVEL, value);
+        }
+        break;
+    case MODBUS_HR_EVENT_PRE:
+        if (value > EVENT_PRE_MAX) {
+            return MODBUS_EX_ILLEGAL_VALUE;
+        }
+        if (apply) {
+            status = EVENT_SetPre(value);
+        }
+        break;
+    case MODBUS_HR_EVENT_POST:
+        if (value == 0U || value > EVENT_POST_MAX) {
+            return MODBUS_EX_ILLEGAL_VALUE;
+        }
+        if (apply) {
+            status = EVENT_SetPost(value);
+        }
+        break;
+#endif
+#if (USE_STATS)
+    case MODBUS_HR_STATS_MODE:
+        if (value >= STATS_MODES) {
+            return MODBUS_EX_ILLEGAL_VALUE;
+        }
+        if (apply) {
+            status = STATS_SetMode(value);
+        }
+        break;
+    case MODBUS_HR_STATS_WINDOW:
+        if (value < STATS_WINDOW_MIN_MS || value > STATS_WINDOW_MAX_MS) {
+            return MODBUS_EX_ILLEGAL_VALUE;
+        }
+        if (apply) {
+            status = STATS_SetWindow(value);
+        }
+        break;
+#endif
+    case MODBUS_HR_FORMAT:
+        if (value >= STREAM_FORMATS) {
+            return MODBUS_EX_ILLEGAL_VALUE;
+        }
+        if (apply) {
+            status = STREAM_SetFormat(value);
+        }
+        break;
+    case MODBUS_HR_AXES:
+        if (value == 0U || (value & ~STREAM_AXES_ALL) != 0U) {
+            return MODBUS_EX_ILLEGAL_VALUE;
+        }
+        if (apply) {
+            status = STREAM_SetAxes(value);
+        }
+        break;
+    default:
+        return MODBUS_EX_ILLEGAL_ADDRESS;
+    }
+    return (status == HAL_OK) ? 0U : MODBUS_EX_DEVICE_FAILURE;
+}
+
+#if (USE_STATS)
+/* Statistics input register n from MODBUS_IR_STATS */
+static uint16_t MODBUS_ReadStats(uint16_t n)
+{
+    const STATS_AxisTypeDef *stats = STATS_GetAxis(n / MODBUS_IR_STATS_AXIS);
+    uint32_t v;
+
+    switch (n % MODBUS_IR_STATS_AXIS) {
+    case 0U: v = (stats->mean + 128U) >> 8;       break;
+    case 1U: v = (stats->rms + 8U) >> 4;          break;
+    case 2U: v = stats->peak;                     break;
+    case 3U: v = stats->max - stats->min;         break;
+    case 4U: v = stats->crest;                    break;
+    case 5U: v = stats->kurtosis;                 break;
+    case 6U: v = stats->min;                      break;
+    default: v = stats->max;                      break;
+    }
+    return (v > 0xFFFFU) ? 0xFFFFU : (uint16_t)v;
+}
+#endif
+
+#endif /* USE_MODBUS */
@@ -0,0 +1,232 @@
+/**
+  ******************************************************************************
+  * @file    prof.c
+  * @brief   Execution profile: how the CPU time splits between threads,
+  *          interrupts and idle.
+  *          With TX_EXECUTION_PROFILE_ENABLE the port calls the ThreadX
+  *          execution hooks from PendSV as threads are switched in and out,
+  *          and from SysTick; the other interrupt handlers bracket their
+  *          body with PROF_ISR_ENTER/EXIT. Every hook charges the time since
+  *          the previous one to what was running, a thread or interrupts.
+  *          The Cortex-M0+ has no DWT cycle counter, so the time source is
+  *          TIM3 free-running at PROF_CLOCK_HZ. A thread is never charged
+  *          more than a SysTick period in one go, well inside the 2 ms wrap
+  *          of the 16-bit count. Idle is the rest of the window as measured
+  *          by the kernel clock, which tickless idle keeps right through
+  *          STOP1, where TIM3 stands still.
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "prof.h"
+#include "tim.h"
+#include "stream.h"
+
+#ifdef TX_EXECUTION_PROFILE_ENABLE
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct {
+    TX_THREAD *thread;
+    uint64_t cycles;
+    uint32_t resumes;
+} PROF_ThreadTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+static PROF_ThreadTypeDef prof_threads[PROF_MAX_THREADS];
+/* Thread being charged, NULL while idle or in the scheduler */
+static PROF_ThreadTypeDef *prof_running;
+static uint64_t prof_isr_cycles;
+static uint32_t prof_irqs;
+static uint32_t prof_nesting;
+/* TIM3 count at the last hook */
+static uint16_t prof_mark;
+/* Tick the current window started at */
+static ULONG prof_start;
+/* Kept off the output thread's stack */
+static uint8_t prof_payload[PROF_HEADER_SIZE + PROF_MAX_THREADS * PROF_RECORD_SIZE];
+
+/* Private function prototypes -----------------------------------------------*/
+static PROF_ThreadTypeDef *PROF_Lookup(TX_THREAD *thread);
+
+static inline void PROF_Put32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/* Counts since the previous call */
+static inline uint32_t PROF_Lap(void)
+{
+    uint16_t now = (uint16_t)__HAL_TIM_GET_COUNTER(&htim3);
+    uint16_t lap = (uint16_t)(now - prof_mark);
+
+    prof_mark = now;
+    return lap;
+}
+
+/**
+  * @brief  Start the TIM3 time source and the first window.
+  * @note   Call after MX_TIM3_Init, before the kernel starts.
+  * @retval None
+  */
+void PROF_Init(void)
+{
+    HAL_TIM_Base_Start(&htim3);
+    prof_mark  = (uint16_t)__HAL_TIM_GET_COUNTER(&htim3);
+    prof_start = tx_time_get();
+}
+
+/**
+  * @brief  Send a STREAM_TYPE_PROFILE packet for the window since the last
+  *         report and start a new window.
+  * @note   Output thread only, as for every stream packet.
+  * @retval None
+  */
+void PROF_Report(void)
+{
+    TX_INTERRUPT_SAVE_AREA
+    PROF_ThreadTypeDef *t;
+    uint8_t *record = &prof_payload[PROF_HEADER_SIZE];
+    uint64_t cycles, busy;
+    uint32_t window, irqs, i, n = 0;
+    ULONG now;
+
+    TX_DISABLE
+    now        = tx_time_get();
+    window     = (uint32_t)(now - prof_start) * (1000000U / TX_TIMER_TICKS_PER_SECOND);
+    prof_start = now;
+    busy       = prof_isr_cycles;
+    irqs       = prof_irqs;
+    prof_isr_cycles = 0;
+    prof_irqs  = 0;
+    TX_RESTORE
+
+    PROF_Put32(&prof_payload[0], now);
+    PROF_Put32(&prof_payload[4], window);
+    PROF_Put32(&prof_payload[8], (uint32_t)(busy / (PROF_CLOCK_HZ / 1000000U)));
+    PROF_Put32(&prof_payload[12], irqs);
+
+    for (i = 0; i < PROF_MAX_THREADS && prof_threads[i].thread != NULL; i++) {
+        t = &prof_threads[i];
+        TX_DISABLE
+        cycles = t->cycles;
+        PROF_Put32(&record[4], t->resumes);
+        t->cycles  = 0;
+        t->resumes = 0;
+        TX_RESTORE
+
+        busy += cycles;
+        PROF_Put32(&record[0], (uint32_t)(cycles / (PROF_CLOCK_HZ / 1000000U)));
+        memset(&record[8], 0, PROF_NAME_SIZE);
+        if (t->thread->tx_thread_name != NULL) {
+            strncpy((char *)&record[8], t->thread->tx_thread_name, PROF_NAME_SIZE);
+        }
+        record += PROF_RECORD_SIZE;
+        n++;
+    }
+
+    busy /= PROF_CLOCK_HZ / 1000000U;
+    PROF_Put32(&prof_payload[16], (busy < window) ? window - (uint32_t)busy : 0U);
+    prof_payload[20] = (uint8_t)n;
+    STREAM_Send(STREAM_TYPE_PROFILE, prof_payload, (uint16_t)(PROF_HEADER_SIZE + n * PROF_RECORD_SIZE));
+}
+
+/**
+  * @brief  Kernel start-up hook; PROF_Init has already run.
+  * @retval None
+  */
+VOID _tx_execution_initialize(VOID)
+{
+}
+
+/**
+  * @brief  A thread is switched in, from PendSV.
+  * @retval None
+  */
+VOID _tx_execution_thread_enter(VOID)
+{
+    TX_INTERRUPT_SAVE_AREA
+
+    TX_DISABLE
+    (void)PROF_Lap(); /* scheduler or idle */
+    prof_running = PROF_Lookup(tx_thread_identify());
+    if (prof_running != NULL) {
+        prof_running->resumes++;
+    }
+    TX_RESTORE
+}
+
+/**
+  * @brief  The running thread is switched out, from PendSV.
+  * @retval None
+  */
+VOID _tx_execution_thread_exit(VOID)
+{
+    TX_INTERRUPT_SAVE_AREA
+
+    TX_DISABLE
+    if (prof_running != NULL) {
+        prof_running->cycles += PROF_Lap();
+        prof_running = NULL;
+    }
+    TX_RESTORE
+}
+
+/**
+  * @brief  Interrupt handler entry; nested handlers only count once.
+  * @retval None
+  */
+VOID _tx_execution_isr_enter(VOID)
+{
+    TX_INTERRUPT_SAVE_AREA
+    uint32_t lap;
+
+    TX_DISABLE
+    if (prof_nesting++ == 0U) {
+        lap = PROF_Lap();
+        if (prof_running != NULL) {
+            prof_running->cycles += lap;
+        }
+        prof_irqs++;
+    }
+    TX_RESTORE
+}
+
+/**
+  * @brief  Interrupt handler exit.
+  * @retval None
+  */
+VOID _tx_execution_isr_exit(VOID)
+{
+    TX_INTERRUPT_SAVE_AREA
+
+    TX_DISABLE
+    if (prof_nesting != 0U && --prof_nesting == 0U) {
+        prof_isr_cycles += PROF_Lap();
+    }
+    TX_RESTORE
+}
+
+/* Slot of a thread, claimed on first sight; NULL once all are taken */
+static PROF_ThreadTypeDef *PROF_Lookup(TX_THREAD *thread)
+{
+    uint32_t i;
+
+    if (thread == TX_NULL) {
+        return NULL;
+    }
+    for (i = 0; i < PROF_MAX_THREADS; i++) {
+        if (prof_threads[i].thread == thread) {
+            return &prof_threads[i];
+        }
+        if (prof_threads[i].thread == NULL) {
+            prof_threads[i].thread = thread;
+            return &prof_threads[i];
+        }
+    }
+    return NULL;
+}
+
+#endif /* TX_EXECUTION_PROFILE_ENABLE */
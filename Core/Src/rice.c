@@ -0,0 +1,218 @@
+/**
+  ******************************************************************************
+  * @file    rice.c
+  * @brief   Lossless compression of the raw sample stream.
+  *          Neighbouring samples of an axis differ far less than they
+  *          range, so each block predicts every axis from its previous
+  *          samples with the fixed polynomial predictor, order 1 to 3, that
+  *          leaves the smallest residuals, and Rice codes the residuals
+  *          with a parameter taken from their mean. A subframe that would
+  *          come out longer than the samples themselves is sent verbatim,
+  *          which bounds a block at RICE_BLOCK_MAX. Integer only, a few
+  *          passes over 16 frames per axis and block, in the output
+  *          thread. The packet carries Fletcher sums of the samples so the
+  *          host can prove the decoded stream bit-exact. See rice.h for
+  *          the layout.
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "rice.h"
+
+#if (USE_RICE)
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct {
+    uint8_t *out;
+    uint32_t acc;  /* bits not yet written, at most 7 between calls */
+    uint32_t n;
+} RICE_WriterTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+/* Last samples of each axis in the packet, most recent first */
+static int32_t rice_hist[RICE_AXES][RICE_ORDER_MAX];
+/* Samples of each axis already in the packet */
+static uint32_t rice_count;
+static uint16_t rice_sum1;
+static uint16_t rice_sum2;
+
+/* Private function prototypes -----------------------------------------------*/
+static void RICE_Axis(RICE_WriterTypeDef *w, const uint16_t *raw, uint32_t axis, uint32_t width);
+
+/* Append the bits low bits of v, 24 at most */
+static inline void RICE_Put(RICE_WriterTypeDef *w, uint32_t v, uint32_t bits)
+{
+    w->acc |= v << w->n;
+    for (w->n += bits; w->n >= 8U; w->n -= 8U) {
+        *w->out++ = (uint8_t)w->acc;
+        w->acc >>= 8;
+    }
+}
+
+/* Fixed predictor of the given order from the previous three samples */
+static inline int32_t RICE_Predict(uint32_t order, int32_t x1, int32_t x2, int32_t x3)
+{
+    switch (order) {
+    case 1U:
+        return x1;
+    case 2U:
+        return 2 * x1 - x2;
+    default:
+        return 3 * (x1 - x2) + x3;
+    }
+}
+
+static inline uint32_t RICE_Zigzag(int32_t e)
+{
+    return ((uint32_t)e << 1) ^ (uint32_t)(e >> 31);
+}
+
+/**
+  * @brief  Start a packet: the first samples of each axis go verbatim and
+  *         the check sums restart.
+  * @retval None
+  */
+void RICE_Start(void)
+{
+    rice_count = 0;
+    rice_sum1  = 0;
+    rice_sum2  = 0;
+}
+
+/**
+  * @brief  Code a block into the packet.
+  * @note   Output thread only. The blocks of a packet must be contiguous,
+  *         with the same axes and width.
+  * @param  out : where the block goes, RICE_BLOCK_MAX bytes of room
+  * @param  block : finished block
+  * @param  axes : axes to send, bit 0 x
+  * @param  width : resolution of the samples, 16 bits at most
+  * @retval End of the block, on a byte boundary
+  */
+uint8_t *RICE_Block(uint8_t *out, const ACQ_BlockTypeDef *block, uint32_t axes, uint32_t width)
+{
+    const uint16_t *raw = (const uint16_t *)block->frames;
+    RICE_WriterTypeDef w = {out, 0U, 0U};
+    uint32_t axis;
+
+    for (axis = 0; axis < RICE_AXES; axis++) {
+        if ((axes >> axis) & 1U) {
+            RICE_Axis(&w, raw, axis, width);
+        }
+    }
+    if (w.n != 0U) {
+        *w.out++ = (uint8_t)w.acc;
+    }
+    rice_count += ACQ_BLOCK_FRAMES;
+    return w.out;
+}
+
+/**
+  * @brief  Fletcher sums of the samples coded since RICE_Start.
+  * @retval sum2 << 16 | sum1
+  */
+uint32_t RICE_GetCheck(void)
+{
+    return ((uint32_t)rice_sum2 << 16) | rice_sum1;
+}
+
+/* Code the subframe of one axis */
+static void RICE_Axis(RICE_WriterTypeDef *w, const uint16_t *raw, uint32_t axis, uint32_t width)
+{
+    int32_t *hist = rice_hist[axis];
+    uint32_t cost[RICE_ORDER_MAX] = {0U, 0U, 0U};
+    uint32_t order, best = 1U, warm, n, sum = 0, k, bits, i, u;
+    int32_t x, x1, x2, x3, e;
+
+    /* The order with the least absolute residual, over the frames every
+       order can predict */
+    x1 = hist[0];
+    x2 = hist[1];
+    x3 = hist[2];
+    for (i = 0; i < ACQ_BLOCK_FRAMES; i++) {
+        x = raw[i * ACQ_CHANNELS + axis];
+        if (rice_count + i >= RICE_ORDER_MAX) {
+            for (order = 1U; order <= RICE_ORDER_MAX; order++) {
+                e = x - RICE_Predict(order, x1, x2, x3);
+                cost[order - 1U] += (uint32_t)((e < 0) ? -e : e);
+            }
+        }
+        x3 = x2;
+        x2 = x1;
+        x1 = x;
+    }
+    for (order = 2U; order <= RICE_ORDER_MAX; order++) {
+        if (cost[order - 1U] < cost[best - 1U]) {
+            best = order;
+        }
+    }
+    warm = (rice_count < best) ? best - rice_count : 0U;
+    n    = ACQ_BLOCK_FRAMES - warm;
+
+    /* Rice parameter near log2(0.69 mean), where the code length is least
+       for geometrically distributed residuals */
+    x1 = hist[0];
+    x2 = hist[1];
+    x3 = hist[2];
+    for (i = 0; i < ACQ_BLOCK_FRAMES; i++) {
+        x = raw[i * ACQ_CHANNELS + axis];
+        if (i >= warm) {
+            sum += RICE_Zigzag(x - RICE_Predict(best, x1, x2, x3));
+        }
+        x3 = x2;
+        x2 = x1;
+        x1 = x;
+    }
+    for (k = 0; k < RICE_K_MAX && (n << (k + 1U)) <= ((sum * 11U) >> 4); k++) {
+    }
+
+    /* Exact length, against sending the samples as they are */
+    bits = 2U + RICE_K_BITS + warm * width + n * (k + 1U);
+    x1 = hist[0];
+    x2 = hist[1];
+    x3 = hist[2];
+    for (i = 0; i < ACQ_BLOCK_FRAMES; i++) {
+        x = raw[i * ACQ_CHANNELS + axis];
+        if (i >= warm) {
+            bits += RICE_Zigzag(x - RICE_Predict(best, x1, x2, x3)) >> k;
+        }
+        x3 = x2;
+        x2 = x1;
+        x1 = x;
+    }
+    if (bits >= 2U + ACQ_BLOCK_FRAMES * width) {
+        best = 0;
+        warm = ACQ_BLOCK_FRAMES;
+        RICE_Put(w, 0U, 2U);
+    } else {
+        RICE_Put(w, best, 2U);
+        RICE_Put(w, k, RICE_K_BITS);
+    }
+
+    x1 = hist[0];
+    x2 = hist[1];
+    x3 = hist[2];
+    for (i = 0; i < ACQ_BLOCK_FRAMES; i++) {
+        x = raw[i * ACQ_CHANNELS + axis];
+        if (i < warm) {
+            RICE_Put(w, (uint32_t)x, width);
+        } else {
+            u = RICE_Zigzag(x - RICE_Predict(best, x1, x2, x3));
+            /* Unary quotient: u >> k ones and a zero */
+            for (e = (int32_t)(u >> k); e >= 16; e -= 16) {
+                RICE_Put(w, 0xFFFFU, 16U);
+            }
+            RICE_Put(w, (1UL << e) - 1U, (uint32_t)e + 1U);
+            RICE_Put(w, u & ((1UL << k) - 1U), k);
+        }
+        rice_sum1 = (uint16_t)(rice_sum1 + x);
+        rice_sum2 = (uint16_t)(rice_sum2 + rice_sum1);
+        x3 = x2;
+        x2 = x1;
+        x1 = x;
+    }
+    hist[0] = x1;
+    hist[1] = x2;
+    hist[2] = x3;
+}
+
+#endif /* USE_RICE */
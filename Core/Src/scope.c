@@ -0,0 +1,190 @@
+/**
+  ******************************************************************************
+  * @file    scope.c
+  * @brief   Live x, y and z trace, scrolled by the display controller.
+  *          Redrawing the trace on every update would send the whole band
+  *          over SPI1 each time. Instead the band below the text is made a
+  *          scroll area of the ST7735: time runs down the panel, one line
+  *          of DISP_WIDTH pixels per SCOPE_DECIMATION acquisition blocks,
+  *          and a new line costs that line, the blank line ahead of it and
+  *          a scroll start address, however tall the band.
+  *          The scope thread takes every block from its ACQ_Subscribe
+  *          queue, averages each axis over the block and lets the block go
+  *          at once, so the slow display thread never holds pool blocks.
+  *          The averages wait in a ring for the display thread, which
+  *          draws each as a line joining it to the one before, per axis.
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "scope.h"
+
+#if (USE_DISPLAY) && (USE_SCOPE)
+
+#if (DISP_WIDTH != (1U << SCOPE_WIDTH_BITS))
+#error "DISP_WIDTH must be 1 << SCOPE_WIDTH_BITS"
+#endif
+
+/* Private define ------------------------------------------------------------*/
+#define SCOPE_AXES 3U
+
+/* Private variables ---------------------------------------------------------*/
+static TX_THREAD scope_thread;
+static uint8_t scope_thread_stack[SCOPE_STACK_SIZE];
+static TX_QUEUE scope_queue;
+static ULONG scope_queue_storage[SCOPE_QUEUE_DEPTH];
+
+/* Averages as pixel columns; the scope thread moves the head, the
+   display thread the tail */
+static uint8_t scope_ring[SCOPE_RING][SCOPE_AXES];
+static volatile uint32_t scope_head;
+static volatile uint32_t scope_tail;
+
+/* Display thread only: the line the next average goes to, and the one before */
+static uint16_t scope_line;
+static uint8_t scope_last[SCOPE_AXES];
+static uint8_t scope_started;
+
+volatile uint32_t scope_dropped;
+
+static const uint16_t scope_colours[SCOPE_AXES] = {
+    SCOPE_X_COLOUR, SCOPE_Y_COLOUR, SCOPE_Z_COLOUR
+};
+/* Sent from flash ahead of the newest line */
+static const uint16_t scope_blank[DISP_WIDTH];
+
+/* Private function prototypes -----------------------------------------------*/
+static void SCOPE_Thread(ULONG thread_input);
+static void SCOPE_Update(uint8_t full);
+static void SCOPE_Draw(const uint8_t *columns);
+
+/**
+  * @brief  Subscribe to the acquisition blocks, create the scope thread and
+  *         register the band with the display.
+  * @note   Must run from tx_application_define, after DISP_Init and ACQ_Init.
+  * @retval ThreadX status
+  */
+UINT SCOPE_Init(void)
+{
+    UINT status;
+
+    scope_head    = 0;
+    scope_tail    = 0;
+    scope_dropped = 0;
+
+    status = tx_queue_create(&scope_queue, "scope queue", TX_1_ULONG,
+                             scope_queue_storage, sizeof(scope_queue_storage));
+    if (status == TX_SUCCESS) {
+        status = ACQ_Subscribe(&scope_queue);
+    }
+    if (status == TX_SUCCESS) {
+        status = DISP_AddUpdate(SCOPE_Update);
+    }
+    if (status != TX_SUCCESS) {
+        return status;
+    }
+    return tx_thread_create(&scope_thread, "scope thread", SCOPE_Thread, 0,
+                            scope_thread_stack, SCOPE_STACK_SIZE,
+                            SCOPE_PRIORITY, SCOPE_PRIORITY, TX_NO_TIME_SLICE, TX_AUTO_START);
+}
+
+static void SCOPE_Thread(ULONG thread_input)
+{
+    const ACQ_BlockTypeDef *block;
+    uint32_t sums[SCOPE_AXES] = { 0 }, blocks = 0, shift, head, i;
+    uint8_t *columns;
+    ULONG msg;
+
+    for (;;) {
+        tx_queue_receive(&scope_queue, &msg, TX_WAIT_FOREVER);
+        block = (const ACQ_BlockTypeDef *)msg;
+        for (i = 0; i < ACQ_BLOCK_FRAMES; i++) {
+            sums[0] += block->frames[i].x;
+            sums[1] += block->frames[i].y;
+            sums[2] += block->frames[i].z;
+        }
+        /* Results are block->config->bits wide, the panel takes the top ones */
+        shift = block->config->bits - SCOPE_WIDTH_BITS;
+        ACQ_Release(block);
+
+        if (++blocks < SCOPE_DECIMATION) {
+            continue;
+        }
+        head = scope_head;
+        if (head - scope_tail < SCOPE_RING) {
+            columns = scope_ring[head % SCOPE_RING];
+            for (i = 0; i < SCOPE_AXES; i++) {
+                columns[i] = (uint8_t)((sums[i] / (ACQ_BLOCK_FRAMES * SCOPE_DECIMATION)) >> shift);
+            }
+            scope_head = head + 1U;
+            DISP_Update();
+        } else {
+            scope_dropped++;
+        }
+        for (i = 0; i < SCOPE_AXES; i++) {
+            sums[i] = 0;
+        }
+        blocks = 0;
+    }
+}
+
+/* Display thread: draw the lines waiting, then scroll to the oldest */
+static void SCOPE_Update(uint8_t full)
+{
+    uint32_t tail = scope_tail;
+
+    if (full) {
+        /* The frame has just blanked the band */
+        DISP_ScrollArea(SCOPE_TOP, SCOPE_LINES);
+        scope_line    = SCOPE_TOP;
+        scope_started = 0;
+    }
+    if (tail == scope_head) {
+        return;
+    }
+    do {
+        SCOPE_Draw(scope_ring[tail % SCOPE_RING]);
+        scope_tail = ++tail;
+    } while (tail != scope_head);
+    /* The blank line at the top, the newest line at the bottom */
+    DISP_ScrollTo(scope_line);
+}
+
+/* One line, then blank the next, which is the oldest */
+static void SCOPE_Draw(const uint8_t *columns)
+{
+    /* A display tile: the line is drawn between frames, when the tiles
+       are idle, and the blank line after it sends from flash */
+    uint16_t *pixels = DISP_Line();
+    uint32_t axis, x, from, to;
+
+    if (!scope_started) {
+        for (axis = 0; axis < SCOPE_AXES; axis++) {
+            scope_last[axis] = columns[axis];
+        }
+        scope_started = 1;
+    }
+    for (x = 0; x < DISP_WIDTH; x++) {
+        pixels[x] = DISP_BLACK;
+    }
+    pixels[DISP_WIDTH / 2U] = SCOPE_MID_COLOUR;
+    for (axis = 0; axis < SCOPE_AXES; axis++) {
+        from = scope_last[axis];
+        to   = columns[axis];
+        if (from > to) {
+            from = to;
+            to   = scope_last[axis];
+        }
+        for (x = from; x <= to; x++) {
+            pixels[x] = scope_colours[axis];
+        }
+        scope_last[axis] = columns[axis];
+    }
+    DISP_Blit(0, scope_line, DISP_WIDTH, 1, pixels);
+
+    if (++scope_line == SCOPE_TOP + SCOPE_LINES) {
+        scope_line = SCOPE_TOP;
+    }
+    DISP_Blit(0, scope_line, DISP_WIDTH, 1, scope_blank);
+}
+
+#endif /* USE_DISPLAY && USE_SCOPE */
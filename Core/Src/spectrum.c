@@ -0,0 +1,232 @@
+/**
+  ******************************************************************************
+  * @file    spectrum.c
+  * @brief   Fixed-point vibration spectrum.
+  *          Each axis collects SPECTRUM_FFT_LEN samples. When the window is
+  *          full the mean is removed, a Hann window applied and the q15 real
+  *          FFT and magnitude kernels of CMSIS-DSP run in the output thread;
+  *          the M0+ has no FPU, so nothing here is floating point. The result
+  *          goes out as the top SPECTRUM_PEAKS bins per axis, or as every bin.
+  *          See spectrum.h for the packet layout.
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "spectrum.h"
+#include "stream.h"
+#include "arm_math.h"
+
+#if (USE_SPECTRUM)
+
+/* Private define ------------------------------------------------------------*/
+#define SPECTRUM_BINS  (SPECTRUM_FFT_LEN / 2U)
+/* Bins per STREAM_TYPE_BINS packet */
+#define SPECTRUM_CHUNK (SPECTRUM_BINS / 2U)
+
+#if (SPECTRUM_FFT_LEN % ACQ_BLOCK_FRAMES) != 0U
+#error "SPECTRUM_FFT_LEN must be a multiple of ACQ_BLOCK_FRAMES"
+#endif
+
+#if SPECTRUM_PEAKS
+#define SPECTRUM_PAYLOAD_SIZE (SPECTRUM_HEADER_SIZE + SPECTRUM_AXES * SPECTRUM_PEAKS * 3U)
+#else
+#define SPECTRUM_PAYLOAD_SIZE (SPECTRUM_HEADER_SIZE + 2U + SPECTRUM_CHUNK * 2U)
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+/* First half of a symmetric 256-point Hann window, q15 */
+static const q15_t spectrum_hann[SPECTRUM_FFT_LEN / 2U] = {
+        0,     5,    20,    45,    80,   124,   179,   243,
+      317,   401,   495,   598,   711,   833,   965,  1106,
+     1257,  1416,  1585,  1763,  1949,  2145,  2349,  2561,
+     2782,  3011,  3249,  3494,  3747,  4008,  4276,  4552,
+     4834,  5124,  5421,  5724,  6034,  6350,  6672,  7000,
+     7334,  7673,  8018,  8367,  8722,  9081,  9444,  9812,
+    10184, 10559, 10938, 11321, 11706, 12094, 12485, 12879,
+    13274, 13671, 14070, 14470, 14872, 15274, 15677, 16081,
+    16484, 16888, 17291, 17694, 18096, 18497, 18897, 19295,
+    19691, 20085, 20477, 20867, 21254, 21638, 22019, 22396,
+    22770, 23139, 23505, 23866, 24223, 24575, 24922, 25264,
+    25601, 25932, 26257, 26576, 26889, 27195, 27495, 27789,
+    28075, 28354, 28626, 28891, 29148, 29397, 29638, 29871,
+    30096, 30313, 30521, 30721, 30912, 31094, 31267, 31432,
+    31587, 31732, 31869, 31996, 32114, 32222, 32320, 32409,
+    32488, 32557, 32617, 32666, 32706, 32736, 32756, 32766
+};
+
+/* Raw samples per axis, windowed in place and consumed by the FFT */
+static q15_t spectrum_in[SPECTRUM_AXES][SPECTRUM_FFT_LEN];
+/* Complex FFT output, then magnitudes in place */
+static q15_t spectrum_out[2U * SPECTRUM_FFT_LEN];
+static uint8_t spectrum_payload[SPECTRUM_PAYLOAD_SIZE];
+static arm_rfft_instance_q15 spectrum_rfft;
+static uint32_t spectrum_fill;
+static uint32_t spectrum_next_block;
+static ULONG spectrum_stamp;
+static uint32_t spectrum_block;
+
+/* Private function prototypes -----------------------------------------------*/
+static void SPECTRUM_Run(uint32_t axis);
+static void SPECTRUM_Header(uint8_t count);
+
+static inline void SPECTRUM_Put16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+/**
+  * @brief  Prepare the real FFT tables.
+  * @retval None
+  */
+void SPECTRUM_Init(void)
+{
+    arm_rfft_init_q15(&spectrum_rfft, SPECTRUM_FFT_LEN, 0, 1);
+    spectrum_fill = 0;
+}
+
+/**
+  * @brief  Add an acquisition block to the window and emit the spectrum
+  *         once the window is full.
+  * @note   Matches ACQ_CallbackTypeDef. A gap in the block counter restarts
+  *         the window, since the FFT needs contiguous samples.
+  * @param  block : finished block
+  * @retval None
+  */
+void SPECTRUM_Block(const ACQ_BlockTypeDef *block)
+{
+    uint32_t i, axis;
+    uint32_t bits = block->config->bits;
+
+    STREAM_Describe(block);
+    if (spectrum_fill != 0U && block->seq != spectrum_next_block) {
+        spectrum_fill = 0;
+    }
+    if (spectrum_fill == 0U) {
+        spectrum_stamp = block->stamp;
+        spectrum_block = block->seq;
+    }
+    spectrum_next_block = block->seq + 1U;
+
+    /* Bring every resolution to 15-bit codes, 16-bit ones lose their LSB */
+    for (i = 0; i < ACQ_BLOCK_FRAMES; i++) {
+        const ACQ_FrameTypeDef *f = &block->frames[i];
+
+        if (bits < 16U) {
+            spectrum_in[0][spectrum_fill + i] = (q15_t)(f->x << (15U - bits));
+            spectrum_in[1][spectrum_fill + i] = (q15_t)(f->y << (15U - bits));
+            spectrum_in[2][spectrum_fill + i] = (q15_t)(f->z << (15U - bits));
+        } else {
+            spectrum_in[0][spectrum_fill + i] = (q15_t)(f->x >> 1);
+            spectrum_in[1][spectrum_fill + i] = (q15_t)(f->y >> 1);
+            spectrum_in[2][spectrum_fill + i] = (q15_t)(f->z >> 1);
+        }
+    }
+    spectrum_fill += ACQ_BLOCK_FRAMES;
+    if (spectrum_fill < SPECTRUM_FFT_LEN) {
+        return;
+    }
+    spectrum_fill = 0;
+
+    for (axis = 0; axis < SPECTRUM_AXES; axis++) {
+        SPECTRUM_Run(axis);
+    }
+#if SPECTRUM_PEAKS
+    SPECTRUM_Header(SPECTRUM_PEAKS);
+    STREAM_Send(STREAM_TYPE_PEAKS, spectrum_payload, SPECTRUM_PAYLOAD_SIZE);
+#endif
+}
+
+/* Window one axis, transform it and report its magnitudes */
+static void SPECTRUM_Run(uint32_t axis)
+{
+    q15_t *x = spectrum_in[axis];
+    int32_t sum = 0;
+    int32_t mean, v;
+    uint32_t i;
+
+    for (i = 0; i < SPECTRUM_FFT_LEN; i++) {
+        sum += x[i];
+    }
+    mean = sum / (int32_t)SPECTRUM_FFT_LEN;
+
+    /* 15-bit codes less the mean span +-2^14, a bit of headroom left */
+    for (i = 0; i < SPECTRUM_FFT_LEN / 2U; i++) {
+        v                             = x[i] - mean;
+        x[i]                          = (q15_t)((v * spectrum_hann[i]) >> 15);
+        v                             = x[SPECTRUM_FFT_LEN - 1U - i] - mean;
+        x[SPECTRUM_FFT_LEN - 1U - i]  = (q15_t)((v * spectrum_hann[i]) >> 15);
+    }
+
+    arm_rfft_q15(&spectrum_rfft, x, spectrum_out);
+    arm_cmplx_mag_q15(spectrum_out, spectrum_out, SPECTRUM_BINS);
+
+#if SPECTRUM_PEAKS
+    {
+        /* Insertion into a descending top-K list, DC bin skipped */
+        uint8_t *peaks = &spectrum_payload[SPECTRUM_HEADER_SIZE + axis * SPECTRUM_PEAKS * 3U];
+        uint8_t bin[SPECTRUM_PEAKS];
+        q15_t mag[SPECTRUM_PEAKS];
+        uint32_t k, n = 0;
+
+        for (i = 1; i < SPECTRUM_BINS; i++) {
+            if (n == SPECTRUM_PEAKS && spectrum_out[i] <= mag[n - 1U]) {
+                continue;
+            }
+            k = (n < SPECTRUM_PEAKS) ? n++ : n - 1U;
+            for (; k > 0U && mag[k - 1U] < spectrum_out[i]; k--) {
+                mag[k] = mag[k - 1U];
+                bin[k] = bin[k - 1U];
+            }
+            mag[k] = spectrum_out[i];
+            bin[k] = (uint8_t)i;
+        }
+        for (k = 0; k < SPECTRUM_PEAKS; k++) {
+            peaks[3U * k] = bin[k];
+            SPECTRUM_Put16(&peaks[3U * k + 1U], (uint16_t)mag[k]);
+        }
+    }
+#else
+    {
+        uint32_t first;
+
+        for (first = 0; first < SPECTRUM_BINS; first += SPECTRUM_CHUNK) {
+            SPECTRUM_Header(SPECTRUM_CHUNK);
+            spectrum_payload[SPECTRUM_HEADER_SIZE]      = (uint8_t)axis;
+            spectrum_payload[SPECTRUM_HEADER_SIZE + 1U] = (uint8_t)first;
+            for (i = 0; i < SPECTRUM_CHUNK; i++) {
+                SPECTRUM_Put16(&spectrum_payload[SPECTRUM_HEADER_SIZE + 2U + 2U * i], (uint16_t)spectrum_out[first + i]);
+            }
+            STREAM_Send(STREAM_TYPE_BINS, spectrum_payload, SPECTRUM_PAYLOAD_SIZE);
+        }
+    }
+#endif
+}
+
+static void SPECTRUM_Header(uint8_t count)
+{
+    SPECTRUM_Put16(&spectrum_payload[0], (uint16_t)spectrum_stamp);
+    SPECTRUM_Put16(&spectrum_payload[2], (uint16_t)(spectrum_stamp >> 16));
+    SPECTRUM_Put16(&spectrum_payload[4], (uint16_t)spectrum_block);
+    SPECTRUM_Put16(&spectrum_payload[6], (uint16_t)(spectrum_block >> 16));
+    SPECTRUM_Put16(&spectrum_payload[8], SPECTRUM_FFT_LEN);
+    spectrum_payload[10] = count;
+}
+
+#if SPECTRUM_PEAKS
+/**
+  * @brief  One entry of the last peak list sent.
+  * @param  axis : 0 x, 1 y, 2 z
+  * @param  rank : 0 for the largest peak, up to SPECTRUM_PEAKS - 1
+  * @param  mag : receives the magnitude
+  * @retval Bin number, 0 before the first spectrum
+  */
+uint8_t SPECTRUM_GetPeak(uint32_t axis, uint32_t rank, uint16_t *mag)
+{
+    const uint8_t *peak = &spectrum_payload[SPECTRUM_HEADER_SIZE + (axis * SPECTRUM_PEAKS + rank) * 3U];
+
+    *mag = (uint16_t)(peak[1] | (peak[2] << 8));
+    return peak[0];
+}
+#endif
+
+#endif /* USE_SPECTRUM */
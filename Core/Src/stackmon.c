@@ -0,0 +1,184 @@
+/**
+  ******************************************************************************
+  * @file    stackmon.c
+  * @brief   Stack high-water monitoring.
+  *          ThreadX fills every thread stack with 0xEF at creation and, with
+  *          TX_ENABLE_STACK_CHECKING, checks the stack pointer and the
+  *          bottom of the stack on each context switch, reporting overflows
+  *          to STACKMON_Overflow. The system stack that main and every
+  *          interrupt handler run on is filled here, below the caller of
+  *          STACKMON_Init, and its bottom byte is the overflow guard. The
+  *          peak use of a stack is how far the fill has been worn away from
+  *          its top; STACKMON_Report sends it for every stack so that the
+  *          stacks can be sized from measurements.
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "stackmon.h"
+#include "defer.h"
+#include "stream.h"
+#include "tx_thread.h"
+
+#ifdef TX_ENABLE_STACK_CHECKING
+
+/* Private define ------------------------------------------------------------*/
+#define STACKMON_FILL_BYTE ((uint8_t)STACKMON_FILL)
+
+#if defined(__ARMCC_VERSION)
+/* Bounds of the STACK area in startup_stm32g031xx.s, from the linker */
+extern uint8_t STACK$$Base[];
+extern uint8_t STACK$$Limit[];
+#define STACKMON_SYS_BASE  (STACK$$Base)
+#define STACKMON_SYS_LIMIT (STACK$$Limit)
+#else
+#define STACKMON_SYS_BASE  ((uint8_t *)NULL)
+#define STACKMON_SYS_LIMIT ((uint8_t *)NULL)
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+/* Thread ThreadX last reported */
+static TX_THREAD *stackmon_culprit;
+static uint8_t stackmon_sys_overflow;
+/* Overflow count the last report was posted for */
+static uint32_t stackmon_posted;
+
+volatile uint32_t stackmon_overflows;
+
+/* Private function prototypes -----------------------------------------------*/
+static VOID STACKMON_Overflow(TX_THREAD *thread);
+static void STACKMON_Deliver(ULONG arg, ULONG stamp);
+static uint32_t STACKMON_Scan(const uint8_t *start, uint32_t size);
+
+static inline void STACKMON_Put16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+/**
+  * @brief  Fill the unused part of the system stack and register for the
+  *         ThreadX overflow reports.
+  * @note   Call at the start of tx_application_define, still on the system stack.
+  * @retval ThreadX status
+  */
+UINT STACKMON_Init(void)
+{
+    uint8_t *p = STACKMON_SYS_BASE, *end;
+
+    if (p != NULL) {
+        end = (uint8_t *)(uintptr_t)__get_MSP() - STACKMON_SYS_GUARD;
+        while (p < end) {
+            *p++ = STACKMON_FILL_BYTE;
+        }
+    }
+    stackmon_culprit      = TX_NULL;
+    stackmon_sys_overflow = 0;
+    stackmon_overflows    = 0;
+    stackmon_posted       = 0;
+    return tx_thread_stack_error_notify(STACKMON_Overflow);
+}
+
+/**
+  * @brief  Check the system stack guard and post a report to the output
+  *         thread when a new overflow has been seen.
+  * @note   Thread context, from a periodic thread.
+  * @retval None
+  */
+void STACKMON_Poll(void)
+{
+    if (STACKMON_SYS_BASE != NULL && !stackmon_sys_overflow &&
+        STACKMON_SYS_BASE[0] != STACKMON_FILL_BYTE) {
+        stackmon_sys_overflow = 1;
+        stackmon_overflows++;
+    }
+    if (stackmon_overflows != stackmon_posted &&
+        DEFER_Post(STACKMON_Deliver, 0) == TX_SUCCESS) {
+        stackmon_posted = stackmon_overflows;
+    }
+}
+
+/**
+  * @brief  Send one STREAM_TYPE_STACK packet per stack, the system stack first.
+  * @note   Output thread only, as for every stream packet.
+  * @retval None
+  */
+void STACKMON_Report(void)
+{
+    uint8_t record[STACKMON_RECORD_SIZE];
+    TX_THREAD *thread = _tx_thread_created_ptr;
+    ULONG stamp = tx_time_get();
+    uint32_t count = _tx_thread_created_count + 1U, i, size, peak;
+    uint8_t overflow;
+    const CHAR *name;
+
+    if (count > 255U) {
+        count = 255U;
+    }
+    for (i = 0; i < count; i++) {
+        if (i == 0U) {
+            size     = (uint32_t)(STACKMON_SYS_LIMIT - STACKMON_SYS_BASE);
+            peak     = STACKMON_Scan(STACKMON_SYS_BASE, size);
+            overflow = stackmon_sys_overflow;
+            name     = "system";
+        } else {
+            size     = thread->tx_thread_stack_size;
+            peak     = STACKMON_Peak(thread);
+            overflow = (thread == stackmon_culprit);
+            name     = thread->tx_thread_name;
+            thread   = thread->tx_thread_created_next;
+        }
+        memset(record, 0, sizeof(record));
+        record[0] = (uint8_t)stamp;
+        record[1] = (uint8_t)(stamp >> 8);
+        record[2] = (uint8_t)(stamp >> 16);
+        record[3] = (uint8_t)(stamp >> 24);
+        record[4] = (uint8_t)i;
+        record[5] = (uint8_t)count;
+        STACKMON_Put16(&record[6], (uint16_t)size);
+        STACKMON_Put16(&record[8], (uint16_t)peak);
+        record[10] = (uint8_t)(overflow || (size != 0U && peak >= size));
+        if (name != NULL) {
+            strncpy((char *)&record[12], name, STACKMON_NAME_SIZE);
+        }
+        STREAM_Send(STREAM_TYPE_STACK, record, sizeof(record));
+    }
+}
+
+/**
+  * @brief  Most bytes a thread has had on its stack since it was created.
+  * @param  thread : created thread
+  * @retval Byte count, the stack size once the bottom has been reached
+  */
+uint32_t STACKMON_Peak(const TX_THREAD *thread)
+{
+    return STACKMON_Scan((const uint8_t *)thread->tx_thread_stack_start, thread->tx_thread_stack_size);
+}
+
+/* From the ThreadX stack check, in whatever context found it: note it only */
+static VOID STACKMON_Overflow(TX_THREAD *thread)
+{
+    stackmon_culprit = thread;
+    stackmon_overflows++;
+}
+
+static void STACKMON_Deliver(ULONG arg, ULONG stamp)
+{
+    STACKMON_Report();
+}
+
+/* Stacks grow down: bytes above the last intact fill byte from the bottom */
+static uint32_t STACKMON_Scan(const uint8_t *start, uint32_t size)
+{
+    uint32_t unused = 0;
+
+    if (start == NULL) {
+        return 0;
+    }
+    while (unused < size && start[unused] == STACKMON_FILL_BYTE) {
+        unused++;
+    }
+    return size - unused;
+}
+
+#endif /* TX_ENABLE_STACK_CHECKING */
@@ -0,0 +1,366 @@
+/**
+  ******************************************************************************
+  * @file    stats.c
+  * @brief   Vibration statistics per axis over fixed windows.
+  *          Dashboards mostly need RMS, peak, crest factor, mean and
+  *          kurtosis, not the samples. Block by block, in the output
+  *          thread, each sample is taken relative to a reference - the
+  *          mean of the window before - and its first to fourth powers
+  *          are added to 64-bit sums, along with the minimum and maximum.
+  *          At the end of a window the sums are moved to the window mean
+  *          and turned into the figures of stats.h in integer arithmetic;
+  *          the M0+ has no FPU. Moments are taken at STATS_MOMENT_BITS
+  *          bits at most, so x^4 summed over STATS_WINDOW_MAX_MS of frames
+  *          fits 64 bits at any oversampling ratio. The record replaces a
+  *          second of samples at about 1 % of the bytes.
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "stats.h"
+#include "stream.h"
+
+#if (USE_STATS)
+
+#if (STATS_WINDOW_MAX_MS * 1000U / ACQ_BASE_PERIOD_US) > 10000U
+#error "A window of more than 10000 frames may overflow the sum of x^4"
+#endif
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct {
+    int64_t s1;    /* sums of d .. d^4, d = (x - ref) >> stats_shift */
+    uint64_t s2;
+    int64_t s3;
+    uint64_t s4;
+    uint16_t ref;  /* codes */
+    uint16_t min;
+    uint16_t max;
+} STATS_SumsTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+static ACQ_CallbackTypeDef stats_next;
+static uint32_t stats_mode;
+static uint32_t stats_window_ms;
+
+/* Window being summed */
+static STATS_SumsTypeDef stats_sums[STATS_AXES];
+static uint8_t stats_open;
+static uint8_t stats_ref_valid;
+static uint32_t stats_generation;
+static uint32_t stats_first_block;
+static uint32_t stats_window_blocks;
+static uint32_t stats_frames;
+static uint32_t stats_shift;
+
+/* Last window, for Modbus */
+static STATS_AxisTypeDef stats_axes[STATS_AXES];
+static uint8_t stats_payload[STATS_HEADER_SIZE + STATS_AXES * STATS_AXIS_SIZE];
+
+/* Private function prototypes -----------------------------------------------*/
+static void STATS_Open(const ACQ_BlockTypeDef *block);
+static void STATS_Close(const ACQ_BlockTypeDef *block);
+static void STATS_Axis(STATS_SumsTypeDef *sums, uint32_t n, STATS_AxisTypeDef *out);
+static uint32_t STATS_Sqrt(uint64_t v);
+
+static inline void STATS_Put16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void STATS_Put32(uint8_t *p, uint32_t v)
+{
+    STATS_Put16(p, (uint16_t)v);
+    STATS_Put16(p + 2, (uint16_t)(v >> 16));
+}
+
+static inline uint16_t STATS_Clip16(uint64_t v)
+{
+    return (v > 0xFFFFU) ? 0xFFFFU : (uint16_t)v;
+}
+
+/**
+  * @brief  Select STATS_MODE and STATS_WINDOW_MS.
+  * @note   Call before ACQ_Init.
+  * @param  next : callback the blocks go on to, except with STATS_MODE_ONLY
+  * @retval None
+  */
+void STATS_Init(ACQ_CallbackTypeDef next)
+{
+    stats_next      = next;
+    stats_mode      = STATS_MODE;
+    stats_window_ms = STATS_WINDOW_MS;
+    stats_open      = 0;
+    stats_ref_valid = 0;
+}
+
+/**
+  * @brief  Add a block to the window, send the record when the window is
+  *         over, and pass the block on.
+  * @note   Matches ACQ_CallbackTypeDef. Lost blocks are left out of the
+  *         window, a new sampling set-up drops it and starts afresh.
+  * @param  block : finished block
+  * @retval None
+  */
+void STATS_Block(const ACQ_BlockTypeDef *block)
+{
+    const uint16_t *raw = (const uint16_t *)block->frames;
+    STATS_SumsTypeDef *sums;
+    uint32_t axis, i, d2, x;
+    int32_t d, a1;
+    uint32_t a2;
+    int64_t a3;
+    uint64_t a4;
+
+    if (stats_mode == STATS_MODE_OFF) {
+        stats_next(block);
+        return;
+    }
+    if (!stats_open || block->config->generation != stats_generation) {
+        STATS_Open(block);
+    }
+
+    for (axis = 0; axis < STATS_AXES; axis++) {
+        sums = &stats_sums[axis];
+        a1 = 0;
+        a2 = 0;
+        a3 = 0;
+        a4 = 0;
+        for (i = 0; i < ACQ_BLOCK_FRAMES; i++) {
+            x = raw[i * ACQ_CHANNELS + axis];
+            if (x < sums->min) {
+                sums->min = (uint16_t)x;
+            }
+            if (x > sums->max) {
+                sums->max = (uint16_t)x;
+            }
+            d  = ((int32_t)x - sums->ref) >> stats_shift;
+            d2 = (uint32_t)(d * d);
+            a1 += d;
+            a2 += d2;
+            a3 += (int64_t)d2 * d;
+            a4 += (uint64_t)d2 * d2;
+        }
+        sums->s1 += a1;
+        sums->s2 += a2;
+        sums->s3 += a3;
+        sums->s4 += a4;
+    }
+    stats_frames += ACQ_BLOCK_FRAMES;
+    if (block->seq - stats_first_block + 1U >= stats_window_blocks) {
+        STATS_Close(block);
+    }
+
+    if (stats_mode != STATS_MODE_ONLY) {
+        stats_next(block);
+    }
+}
+
+/**
+  * @brief  Select the mode, from the next block on.
+  * @note   Output thread only, as STATS_Block. The window starts afresh.
+  * @param  mode : STATS_MODE_xxx
+  * @retval HAL_ERROR for an unknown mode
+  */
+HAL_StatusTypeDef STATS_SetMode(uint32_t mode)
+{
+    if (mode >= STATS_MODES) {
+        return HAL_ERROR;
+    }
+    stats_mode = mode;
+    stats_open = 0;
+    return HAL_OK;
+}
+
+/**
+  * @brief  Mode in use.
+  * @retval STATS_MODE_xxx
+  */
+uint32_t STATS_GetMode(void)
+{
+    return stats_mode;
+}
+
+/**
+  * @brief  Set the window length, from the next block on.
+  * @note   Output thread only, as STATS_Block. The window starts afresh.
+  * @param  ms : STATS_WINDOW_MIN_MS to STATS_WINDOW_MAX_MS
+  * @retval HAL_ERROR out of range
+  */
+HAL_StatusTypeDef STATS_SetWindow(uint32_t ms)
+{
+    if (ms < STATS_WINDOW_MIN_MS || ms > STATS_WINDOW_MAX_MS) {
+        return HAL_ERROR;
+    }
+    stats_window_ms = ms;
+    stats_open      = 0;
+    return HAL_OK;
+}
+
+/**
+  * @brief  Window length.
+  * @retval ms
+  */
+uint32_t STATS_GetWindow(void)
+{
+    return stats_window_ms;
+}
+
+/**
+  * @brief  Figures of one axis over the last window.
+  * @param  axis : 0 x, 1 y, 2 z
+  * @retval All zero before the first window, NULL for an unknown axis
+  */
+const STATS_AxisTypeDef *STATS_GetAxis(uint32_t axis)
+{
+    return (axis < STATS_AXES) ? &stats_axes[axis] : NULL;
+}
+
+/* Start a window with block */
+static void STATS_Open(const ACQ_BlockTypeDef *block)
+{
+    const ACQ_ConfigTypeDef *config = block->config;
+    const uint16_t *raw = (const uint16_t *)block->frames;
+    uint32_t block_us = config->period_us * ACQ_BLOCK_FRAMES, axis;
+    STATS_SumsTypeDef *sums;
+
+    if (config->generation != stats_generation) {
+        stats_generation = config->generation;
+        stats_ref_valid  = 0;
+    }
+    stats_window_blocks = (stats_window_ms * 1000U + block_us / 2U) / block_us;
+    if (stats_window_blocks == 0U) {
+        stats_window_blocks = 1;
+    }
+    stats_shift = (config->bits > STATS_MOMENT_BITS) ? config->bits - STATS_MOMENT_BITS : 0U;
+
+    for (axis = 0; axis < STATS_AXES; axis++) {
+        sums = &stats_sums[axis];
+        sums->s1  = 0;
+        sums->s2  = 0;
+        sums->s3  = 0;
+        sums->s4  = 0;
+        sums->min = 0xFFFFU;
+        sums->max = 0;
+        if (!stats_ref_valid) {
+            sums->ref = raw[axis];
+        }
+    }
+    stats_ref_valid   = 1;
+    stats_first_block = block->seq;
+    stats_frames      = 0;
+    stats_open        = 1;
+}
+
+/* Finish the window ending with block and send its record */
+static void STATS_Close(const ACQ_BlockTypeDef *block)
+{
+    const ACQ_ConfigTypeDef *config = block->config;
+    STATS_AxisTypeDef *axis_out;
+    uint8_t *out;
+    uint32_t axis;
+
+    STATS_Put32(&stats_payload[0], block->stamp);
+    STATS_Put32(&stats_payload[4], stats_first_block);
+    STATS_Put32(&stats_payload[8], config->period_us);
+    STATS_Put16(&stats_payload[12], (uint16_t)stats_frames);
+    stats_payload[14] = config->bits;
+    stats_payload[15] = STATS_AXES;
+
+    for (axis = 0; axis < STATS_AXES; axis++) {
+        axis_out = &stats_axes[axis];
+        STATS_Axis(&stats_sums[axis], stats_frames, axis_out);
+        /* The next window is summed about this one's mean */
+        stats_sums[axis].ref = (uint16_t)((axis_out->mean + 128U) >> 8);
+
+        out = &stats_payload[STATS_HEADER_SIZE + axis * STATS_AXIS_SIZE];
+        STATS_Put32(&out[0], axis_out->mean);
+        STATS_Put32(&out[4], axis_out->rms);
+        STATS_Put16(&out[8], axis_out->min);
+        STATS_Put16(&out[10], axis_out->max);
+        STATS_Put16(&out[12], axis_out->peak);
+        STATS_Put16(&out[14], axis_out->crest);
+        STATS_Put16(&out[16], axis_out->kurtosis);
+    }
+    STREAM_Send(STREAM_TYPE_STATS, stats_payload, sizeof(stats_payload));
+    stats_open = 0;
+}
+
+/* Figures from the sums of n frames. The sums are moved from the reference
+   to the nearest whole code m of the mean; unsigned arithmetic wraps, and
+   the results, being sums of non-negative powers, fit again. */
+static void STATS_Axis(STATS_SumsTypeDef *sums, uint32_t n, STATS_AxisTypeDef *out)
+{
+    int64_t s1 = sums->s1, r, mean;
+    int32_t m;
+    uint64_t um, b2, b4, var, k;
+    uint32_t rms, centre, peak, shift = 0, bits;
+
+    m  = (int32_t)(((s1 >= 0) ? s1 + n / 2U : s1 - (int64_t)(n / 2U)) / (int64_t)n);
+    r  = s1 - (int64_t)n * m;
+    um = (uint64_t)(int64_t)m;
+    b2 = sums->s2 - 2U * um * (uint64_t)s1 + n * um * um;
+    b4 = sums->s4 - 4U * um * (uint64_t)sums->s3 + 6U * um * um * sums->s2 -
+         4U * um * um * um * (uint64_t)s1 + n * um * um * um * um;
+
+    /* Variance about the exact mean: (n b2 - r^2) / n^2, Q16 */
+    var = n * b2 - (uint64_t)(r * r);
+    var = ((var / n) << 16) / n;
+    rms = STATS_Sqrt(var) << stats_shift;
+
+    /* Codes, Q8; flooring d lost half a step of 2^stats_shift on average */
+    mean = ((int64_t)sums->ref << 8) + ((s1 << (8U + stats_shift)) / (int64_t)n) +
+           (((1L << stats_shift) - 1) << 7);
+    if (mean < 0) {
+        mean = 0;
+    }
+
+    centre = (uint32_t)((mean + 128) >> 8);
+    peak   = (sums->max > centre) ? sums->max - centre : 0U;
+    if (sums->min < centre && centre - sums->min > peak) {
+        peak = centre - sums->min;
+    }
+
+    out->mean  = (uint32_t)mean;
+    out->rms   = rms;
+    out->min   = sums->min;
+    out->max   = sums->max;
+    out->peak  = (uint16_t)peak;
+    out->crest = (rms != 0U) ? STATS_Clip16(((uint64_t)peak << 16) / rms) : 0U;
+
+    /* n b4 / b2^2, Q8; b4 <= b2^2, so with b2 under 2^20 nothing overflows */
+    if (b2 == 0U) {
+        out->kurtosis = 0;
+        return;
+    }
+    for (bits = 0; (b2 >> bits) != 0U; bits++) {
+    }
+    if (bits > 20U) {
+        shift = bits - 20U;
+    }
+    b2 >>= shift;
+    b4 >>= 2U * shift;
+    k = (((uint64_t)n * b4) << 8) / (b2 * b2);
+    out->kurtosis = STATS_Clip16(k);
+}
+
+/* Integer square root, rounded down */
+static uint32_t STATS_Sqrt(uint64_t v)
+{
+    uint64_t r = 0, bit = 1ULL << 62;
+
+    while (bit > v) {
+        bit >>= 2;
+    }
+    while (bit != 0U) {
+        if (v >= r + bit) {
+            v -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)r;
+}
+
+#endif /* USE_STATS */
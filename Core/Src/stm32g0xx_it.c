@@ -22,6 +22,10 @@
 #include "stm32g0xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "modbus.h"
+#include "prof.h"
+#include "trace.h"
+#include "latency.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -57,7 +61,14 @@
 /* External variables --------------------------------------------------------*/
 extern DMA_HandleTypeDef hdma_adc1;
 extern ADC_HandleTypeDef hadc1;
+extern LPTIM_HandleTypeDef hlptim1;
+extern DMA_HandleTypeDef hdma_spi1_tx;
 extern TIM_HandleTypeDef htim2;
+extern DMA_HandleTypeDef hdma_usart1_tx;
+extern DMA_HandleTypeDef hdma_usart2_rx;
+extern DMA_HandleTypeDef hdma_usart2_tx;
+extern UART_HandleTypeDef huart1;
+extern UART_HandleTypeDef huart2;
 extern TIM_HandleTypeDef htim17;
 
 /* USER CODE BEGIN EV */
@@ -110,25 +121,64 @@ void HardFault_Handler(void)
 void DMA1_Channel1_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA1_Channel1_IRQn 0 */
-
+  LAT_ISR_ENTER();
+  PROF_ISR_ENTER();
+  TRACE_ISR_ENTER(DMA1_Channel1_IRQn);
   /* USER CODE END DMA1_Channel1_IRQn 0 */
   HAL_DMA_IRQHandler(&hdma_adc1);
   /* USER CODE BEGIN DMA1_Channel1_IRQn 1 */
-
+  TRACE_ISR_EXIT(DMA1_Channel1_IRQn);
+  PROF_ISR_EXIT();
   /* USER CODE END DMA1_Channel1_IRQn 1 */
 }
 
+/**
+  * @brief This function handles DMA1 channel 2 and channel 3 interrupts.
+  */
+void DMA1_Channel2_3_IRQHandler(void)
+{
+  /* USER CODE BEGIN DMA1_Channel2_3_IRQn 0 */
+  PROF_ISR_ENTER();
+  TRACE_ISR_ENTER(DMA1_Channel2_3_IRQn);
+  /* USER CODE END DMA1_Channel2_3_IRQn 0 */
+  HAL_DMA_IRQHandler(&hdma_usart1_tx);
+  HAL_DMA_IRQHandler(&hdma_usart2_tx);
+  /* USER CODE BEGIN DMA1_Channel2_3_IRQn 1 */
+  TRACE_ISR_EXIT(DMA1_Channel2_3_IRQn);
+  PROF_ISR_EXIT();
+  /* USER CODE END DMA1_Channel2_3_IRQn 1 */
+}
+
+/**
+  * @brief This function handles DMA1 channel 4, channel 5 and DMAMUX1 interrupts.
+  */
+void DMA1_Ch4_5_DMAMUX1_OVR_IRQHandler(void)
+{
+  /* USER CODE BEGIN DMA1_Ch4_5_DMAMUX1_OVR_IRQn 0 */
+  PROF_ISR_ENTER();
+  TRACE_ISR_ENTER(DMA1_Ch4_5_DMAMUX1_OVR_IRQn);
+  /* USER CODE END DMA1_Ch4_5_DMAMUX1_OVR_IRQn 0 */
+  HAL_DMA_IRQHandler(&hdma_usart2_rx);
+  HAL_DMA_IRQHandler(&hdma_spi1_tx);
+  /* USER CODE BEGIN DMA1_Ch4_5_DMAMUX1_OVR_IRQn 1 */
+  TRACE_ISR_EXIT(DMA1_Ch4_5_DMAMUX1_OVR_IRQn);
+  PROF_ISR_EXIT();
+  /* USER CODE END DMA1_Ch4_5_DMAMUX1_OVR_IRQn 1 */
+}
+
 /**
   * @brief This function handles ADC1 interrupt.
   */
 void ADC1_IRQHandler(void)
 {
   /* USER CODE BEGIN ADC1_IRQn 0 */
-
+  PROF_ISR_ENTER();
+  TRACE_ISR_ENTER(ADC1_IRQn);
   /* USER CODE END ADC1_IRQn 0 */
   HAL_ADC_IRQHandler(&hadc1);
   /* USER CODE BEGIN ADC1_IRQn 1 */
-
+  TRACE_ISR_EXIT(ADC1_IRQn);
+  PROF_ISR_EXIT();
   /* USER CODE END ADC1_IRQn 1 */
 }
 
@@ -138,28 +188,86 @@ void ADC1_IRQHandler(void)
 void TIM2_IRQHandler(void)
 {
   /* USER CODE BEGIN TIM2_IRQn 0 */
-
+  PROF_ISR_ENTER();
+  TRACE_ISR_ENTER(TIM2_IRQn);
+#if (USE_MODBUS)
+  /* Consumes the t3.5 compare on channel 2 */
+  MODBUS_TIM_IRQHandler(&htim2);
+#endif
   /* USER CODE END TIM2_IRQn 0 */
   HAL_TIM_IRQHandler(&htim2);
   /* USER CODE BEGIN TIM2_IRQn 1 */
-
+  TRACE_ISR_EXIT(TIM2_IRQn);
+  PROF_ISR_EXIT();
   /* USER CODE END TIM2_IRQn 1 */
 }
 
+/**
+  * @brief This function handles LPTIM1 global interrupt.
+  */
+void LPTIM1_IRQHandler(void)
+{
+  /* USER CODE BEGIN LPTIM1_IRQn 0 */
+  PROF_ISR_ENTER();
+  TRACE_ISR_ENTER(LPTIM1_IRQn);
+  /* USER CODE END LPTIM1_IRQn 0 */
+  HAL_LPTIM_IRQHandler(&hlptim1);
+  /* USER CODE BEGIN LPTIM1_IRQn 1 */
+  TRACE_ISR_EXIT(LPTIM1_IRQn);
+  PROF_ISR_EXIT();
+  /* USER CODE END LPTIM1_IRQn 1 */
+}
+
 /**
   * @brief This function handles TIM17 global interrupt.
   */
 void TIM17_IRQHandler(void)
 {
   /* USER CODE BEGIN TIM17_IRQn 0 */
-
+  PROF_ISR_ENTER();
   /* USER CODE END TIM17_IRQn 0 */
   HAL_TIM_IRQHandler(&htim17);
   /* USER CODE BEGIN TIM17_IRQn 1 */
-
+  PROF_ISR_EXIT();
   /* USER CODE END TIM17_IRQn 1 */
 }
 
+/**
+  * @brief This function handles USART1 global interrupt / USART1 wake-up interrupt through EXTI line 25.
+  */
+void USART1_IRQHandler(void)
+{
+  /* USER CODE BEGIN USART1_IRQn 0 */
+  PROF_ISR_ENTER();
+  TRACE_ISR_ENTER(USART1_IRQn);
+  /* USER CODE END USART1_IRQn 0 */
+  HAL_UART_IRQHandler(&huart1);
+  /* USER CODE BEGIN USART1_IRQn 1 */
+  TRACE_ISR_EXIT(USART1_IRQn);
+  PROF_ISR_EXIT();
+  /* USER CODE END USART1_IRQn 1 */
+}
+
+/**
+  * @brief This function handles USART2 global interrupt / USART2 wake-up interrupt through EXTI line 26.
+  */
+void USART2_IRQHandler(void)
+{
+  /* USER CODE BEGIN USART2_IRQn 0 */
+  PROF_ISR_ENTER();
+  TRACE_ISR_ENTER(USART2_IRQn);
+#if (USE_MODBUS)
+  /* Consumes the idle line and the receive error flags */
+  MODBUS_UART_IRQHandler(&huart2);
+#endif
+  /* USER CODE END USART2_IRQn 0 */
+  HAL_UART_IRQHandler(&huart2);
+  /* USER CODE BEGIN USART2_IRQn 1 */
+  TRACE_ISR_EXIT(USART2_IRQn);
+  PROF_ISR_EXIT();
+  /* USER CODE END USART2_IRQn 1 */
+}
+
 /* USER CODE BEGIN 1 */
 
 /* USER CODE END 1 */
@@ -0,0 +1,351 @@
+/**
+  ******************************************************************************
+  * @file    stream.c
+  * @brief   Framed binary sample stream.
+  *          Every packet starts with a sync word and carries a version, a
+  *          type, a sequence number and a length, and ends with a CRC-16
+  *          computed by the CRC peripheral, so the host can find the next
+  *          packet boundary after any lost byte and count lost packets.
+  *          Samples are batched STREAM_BATCH_BLOCKS acquisition blocks per
+  *          packet to amortise the header, as 16-bit words or, with
+  *          STREAM_FORMAT_PACKED, packed to the resolution in use with
+  *          only the selected axes: at 12 bits three quarters of the
+  *          bytes, less again per axis left out, or with
+  *          STREAM_FORMAT_RICE compressed without loss by rice.c, as many
+  *          blocks as fit. See stream.h for the layout.
+  *          Everything but STREAM_SendPacket runs in the output thread
+  *          only, which owns the packet buffer. Framing, the sequence
+  *          counter and the CRC unit are shared with the threads calling
+  *          STREAM_SendPacket under a mutex.
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "stream.h"
+#include "crc.h"
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t stream_buf[STREAM_HEADER_SIZE + STREAM_MAX_PAYLOAD + STREAM_CRC_SIZE];
+static UART_TX_HandleTypeDef *stream_htx;
+static TX_MUTEX stream_lock;
+static uint16_t stream_seq;
+/* Blocks already in the pending samples packet, how many it takes, its
+   type and length */
+static uint32_t stream_blocks;
+static uint32_t stream_batch;
+static uint8_t stream_type;
+static uint16_t stream_length;
+/* STREAM_FORMAT_xxx, and the axes it packs */
+static uint8_t stream_format;
+static uint8_t stream_axes;
+static uint8_t stream_channels;
+/* Block counter the pending samples packet continues with */
+static uint32_t stream_next_block;
+/* Set-up generation and block of the last metadata packet */
+static uint32_t stream_meta_generation;
+static uint32_t stream_meta_block;
+static uint8_t stream_meta_sent;
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t STREAM_Flush(void);
+static uint8_t *STREAM_Pack(uint8_t *out, const ACQ_BlockTypeDef *block, uint32_t width);
+static uint32_t STREAM_Frame(uint8_t *packet, uint8_t type, uint16_t length);
+
+static inline void STREAM_Put16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void STREAM_Put32(uint8_t *p, uint32_t v)
+{
+    STREAM_Put16(p, (uint16_t)v);
+    STREAM_Put16(p + 2, (uint16_t)(v >> 16));
+}
+
+/**
+  * @brief  Select the transmit engine the packets go out on.
+  * @param  htx : initialised transmit engine
+  * @retval ThreadX status
+  */
+UINT STREAM_Init(UART_TX_HandleTypeDef *htx)
+{
+    stream_htx       = htx;
+    stream_seq       = 0;
+    stream_blocks    = 0;
+    stream_meta_sent = 0;
+    stream_format    = STREAM_FORMAT;
+    STREAM_SetAxes(STREAM_AXES);
+    return tx_mutex_create(&stream_lock, "stream lock", TX_INHERIT);
+}
+
+/**
+  * @brief  Send a metadata packet if the sampling set-up of this block has
+  *         not been described yet, or was last described STREAM_META_BLOCKS
+  *         blocks ago.
+  * @note   STREAM_Block calls it; other consumers call it for every block.
+  * @param  block : block about to be streamed
+  * @retval None
+  */
+void STREAM_Describe(const ACQ_BlockTypeDef *block)
+{
+    const ACQ_ConfigTypeDef *config = block->config;
+    uint8_t meta[STREAM_META_SIZE];
+
+    if (stream_meta_sent && config->generation == stream_meta_generation &&
+        block->seq - stream_meta_block < STREAM_META_BLOCKS) {
+        return;
+    }
+    STREAM_Put32(&meta[0], block->stamp);
+    STREAM_Put32(&meta[4], block->seq);
+    STREAM_Put32(&meta[8], config->period_us);
+    STREAM_Put16(&meta[12], config->ratio);
+    meta[14] = config->shift;
+    meta[15] = config->bits;
+    meta[16] = STREAM_CHANNELS;
+    meta[17] = ACQ_BLOCK_FRAMES;
+    STREAM_Send(STREAM_TYPE_META, meta, sizeof(meta));
+
+    stream_meta_generation = config->generation;
+    stream_meta_block      = block->seq;
+    stream_meta_sent       = 1;
+}
+
+/**
+  * @brief  Append an acquisition block to the samples packet and send the
+  *         packet once STREAM_BATCH_BLOCKS blocks are in.
+  * @note   Matches ACQ_CallbackTypeDef. A gap in the block counter or a
+  *         metadata packet closes the packet early so that every packet is
+  *         contiguous in time and sampled with one set-up.
+  * @param  block : finished block
+  * @retval None
+  */
+void STREAM_Block(const ACQ_BlockTypeDef *block)
+{
+    uint8_t *payload = &stream_buf[STREAM_HEADER_SIZE];
+    uint8_t *out;
+    uint64_t time;
+    uint32_t i;
+
+    STREAM_Describe(block);
+    if (stream_blocks != 0U && block->seq != stream_next_block) {
+        STREAM_Flush();
+    }
+#if (USE_RICE)
+    if (stream_blocks != 0U && stream_type == STREAM_TYPE_RICE &&
+        stream_length + RICE_BLOCK_MAX(stream_channels, block->config->bits) > STREAM_MAX_PAYLOAD) {
+        STREAM_Flush();
+    }
+#endif
+    if (stream_blocks == 0U) {
+        STREAM_Put32(&payload[0], block->stamp);
+        STREAM_Put32(&payload[4], block->seq);
+        time = ACQ_GetTime(block);
+        STREAM_Put32(&payload[8], (uint32_t)time);
+        STREAM_Put32(&payload[12], (uint32_t)(time >> 32));
+        stream_batch = STREAM_BATCH_BLOCKS;
+        if (stream_format == STREAM_FORMAT_WORDS) {
+            payload[17]   = STREAM_CHANNELS;
+            stream_type   = STREAM_TYPE_SAMPLES;
+            stream_length = STREAM_SAMPLES_HEADER_SIZE;
+        } else {
+            payload[17]   = stream_axes;
+            payload[18]   = block->config->bits;
+            payload[19]   = stream_channels;
+            stream_type   = STREAM_TYPE_PACKED;
+            stream_length = STREAM_PACKED_HEADER_SIZE;
+#if (USE_RICE)
+            if (stream_format == STREAM_FORMAT_RICE) {
+                RICE_Start();
+                stream_batch  = RICE_BATCH_BLOCKS;
+                stream_type   = STREAM_TYPE_RICE;
+                stream_length = RICE_HEADER_SIZE;
+            }
+#endif
+        }
+    }
+
+    stream_next_block = block->seq + 1U;
+
+    out = &payload[stream_length];
+    if (stream_type == STREAM_TYPE_PACKED) {
+        /* A new resolution comes with a metadata packet, which has closed
+           the packet, so the width in its header still holds */
+        out = STREAM_Pack(out, block, payload[18]);
+#if (USE_RICE)
+    } else if (stream_type == STREAM_TYPE_RICE) {
+        out = RICE_Block(out, block, stream_axes, payload[18]);
+#endif
+    } else {
+        for (i = 0; i < ACQ_BLOCK_FRAMES; i++) {
+            const ACQ_FrameTypeDef *f = &block->frames[i];
+
+            STREAM_Put16(out, f->x);
+            STREAM_Put16(out + 2, f->y);
+            STREAM_Put16(out + 4, f->z);
+            out += STREAM_CHANNELS * 2U;
+        }
+    }
+    stream_length = (uint16_t)(out - payload);
+    if (++stream_blocks == stream_batch) {
+        STREAM_Flush();
+    }
+}
+
+/**
+  * @brief  Send a packet of any type.
+  * @note   Closes a pending samples packet first to keep packets in order.
+  * @param  type : STREAM_TYPE_xxx
+  * @param  payload : payload bytes
+  * @param  length : payload size, at most STREAM_MAX_PAYLOAD
+  * @retval Bytes queued on the UART
+  */
+uint32_t STREAM_Send(uint8_t type, const void *payload, uint16_t length)
+{
+    if (length > STREAM_MAX_PAYLOAD) {
+        return 0;
+    }
+    if (stream_blocks != 0U) {
+        STREAM_Flush();
+    }
+    memcpy(&stream_buf[STREAM_HEADER_SIZE], payload, length);
+    return STREAM_Frame(stream_buf, type, length);
+}
+
+/**
+  * @brief  Send a packet built in the caller's own buffer, from any thread.
+  * @note   The output thread's pending samples packet is not closed first,
+  *         so this packet may overtake it.
+  * @param  type : STREAM_TYPE_xxx
+  * @param  packet : STREAM_HEADER_SIZE bytes of room, the payload, then
+  *         STREAM_CRC_SIZE bytes of room
+  * @param  length : payload size, at most STREAM_MAX_PAYLOAD
+  * @retval Bytes queued on the UART
+  */
+uint32_t STREAM_SendPacket(uint8_t type, uint8_t *packet, uint16_t length)
+{
+    if (length > STREAM_MAX_PAYLOAD) {
+        return 0;
+    }
+    return STREAM_Frame(packet, type, length);
+}
+
+/**
+  * @brief  Select the sample format, from the next samples packet on.
+  * @note   Output thread only, as STREAM_Block. With USE_CAL, the
+  *         formats but STREAM_FORMAT_WORDS send raw codes rather than mg.
+  * @param  format : STREAM_FORMAT_xxx
+  * @retval HAL_ERROR for an unknown format
+  */
+HAL_StatusTypeDef STREAM_SetFormat(uint32_t format)
+{
+    if (format >= STREAM_FORMATS) {
+        return HAL_ERROR;
+    }
+    if (stream_blocks != 0U) {
+        STREAM_Flush();
+    }
+    stream_format = (uint8_t)format;
+    return HAL_OK;
+}
+
+/**
+  * @brief  Sample format in use.
+  * @retval STREAM_FORMAT_xxx
+  */
+uint32_t STREAM_GetFormat(void)
+{
+    return stream_format;
+}
+
+/**
+  * @brief  Select the axes STREAM_FORMAT_PACKED and STREAM_FORMAT_RICE
+  *         send, from the next samples packet on.
+  * @note   Output thread only, as STREAM_Block.
+  * @param  axes : bit 0 x, bit 1 y, bit 2 z, at least one
+  * @retval HAL_ERROR for no axis or an unknown one
+  */
+HAL_StatusTypeDef STREAM_SetAxes(uint32_t axes)
+{
+    uint32_t axis;
+
+    if (axes == 0U || (axes & ~STREAM_AXES_ALL) != 0U) {
+        return HAL_ERROR;
+    }
+    if (stream_blocks != 0U) {
+        STREAM_Flush();
+    }
+    stream_axes     = (uint8_t)axes;
+    stream_channels = 0;
+    for (axis = 0; axis < STREAM_CHANNELS; axis++) {
+        stream_channels += (axes >> axis) & 1U;
+    }
+    return HAL_OK;
+}
+
+/**
+  * @brief  Axes STREAM_FORMAT_PACKED and STREAM_FORMAT_RICE send.
+  * @retval Bit 0 x, bit 1 y, bit 2 z
+  */
+uint32_t STREAM_GetAxes(void)
+{
+    return stream_axes;
+}
+
+/* Close the pending samples packet and queue it */
+static uint32_t STREAM_Flush(void)
+{
+    stream_buf[STREAM_HEADER_SIZE + 16U] = (uint8_t)(stream_blocks * ACQ_BLOCK_FRAMES);
+#if (USE_RICE)
+    if (stream_type == STREAM_TYPE_RICE) {
+        STREAM_Put32(&stream_buf[STREAM_HEADER_SIZE + 20U], RICE_GetCheck());
+    }
+#endif
+    stream_blocks = 0;
+    return STREAM_Frame(stream_buf, stream_type, stream_length);
+}
+
+/* Append the selected axes of a block at width bits a sample, least
+   significant bit first. Whole bytes leave the accumulator as soon as they
+   are complete, so it never holds more than 7 + width bits. */
+static uint8_t *STREAM_Pack(uint8_t *out, const ACQ_BlockTypeDef *block, uint32_t width)
+{
+    const uint16_t *raw = (const uint16_t *)block->frames;
+    const uint16_t *end = raw + ACQ_BLOCK_FRAMES * ACQ_CHANNELS;
+    uint32_t acc = 0, n = 0, axes = stream_axes, axis;
+
+    for (; raw < end; raw += ACQ_CHANNELS) {
+        for (axis = 0; axis < STREAM_CHANNELS; axis++) {
+            if ((axes >> axis) & 1U) {
+                acc |= (uint32_t)raw[axis] << n;
+                for (n += width; n >= 8U; n -= 8U) {
+                    *out++ = (uint8_t)acc;
+                    acc >>= 8;
+                }
+            }
+        }
+    }
+    return out;
+}
+
+/* Fill in the header and CRC around a payload and queue the packet */
+static uint32_t STREAM_Frame(uint8_t *packet, uint8_t type, uint16_t length)
+{
+    uint32_t sent;
+    uint16_t crc;
+
+    tx_mutex_get(&stream_lock, TX_WAIT_FOREVER);
+    packet[0] = STREAM_SYNC0;
+    packet[1] = STREAM_SYNC1;
+    packet[2] = STREAM_VERSION;
+    packet[3] = type;
+    STREAM_Put16(&packet[4], stream_seq++);
+    STREAM_Put16(&packet[6], length);
+
+    crc = (uint16_t)HAL_CRC_Calculate(&hcrc, (uint32_t *)&packet[2], STREAM_HEADER_SIZE - 2U + length);
+    STREAM_Put16(&packet[STREAM_HEADER_SIZE + length], crc);
+
+    sent = UART_TX_Write(stream_htx, packet, STREAM_HEADER_SIZE + length + STREAM_CRC_SIZE);
+    tx_mutex_put(&stream_lock);
+    return sent;
+}
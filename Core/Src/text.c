@@ -0,0 +1,205 @@
+/**
+  ******************************************************************************
+  * @file    text.c
+  * @brief   Character cells on the display, from a cache of expanded glyphs.
+  *          Font bitmaps have one bit per pixel; turning one into RGB565 on
+  *          every character costs more than sending it. The glyphs in use
+  *          are expanded once, per colour pair, into a small cache with
+  *          least recently used replacement, and a cell is then a single
+  *          DMA burst straight from its cache entry. Threads write the
+  *          wanted text with TEXT_Print and TEXT_Number; the display thread
+  *          compares it with what is on the panel and sends only the cells
+  *          that differ, all of them after a whole frame.
+  *          Readouts that keep their width change a digit or two per
+  *          update, so the cache mostly holds digits and the panel traffic
+  *          is a few cells per update.
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "text.h"
+
+#if (USE_DISPLAY)
+
+#if (TEXT_CACHE_GLYPHS < 2U)
+#error "TEXT_CACHE_GLYPHS must be at least 2"
+#endif
+
+/* Private define ------------------------------------------------------------*/
+/* A cell is its character in the low byte and its attribute above */
+#define TEXT_CELL(c, attr) ((uint16_t)((uint8_t)(c) | ((uint16_t)(attr) << 8)))
+/* Never wanted: the cell is redrawn */
+#define TEXT_STALE         0xFFFFU
+
+#define TEXT_FIRST_CHAR    ' '
+#define TEXT_LAST_CHAR     '~'
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct {
+    uint16_t fg;
+    uint16_t bg;
+} TEXT_ColoursTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+/* Written by any thread, read by the display thread; a cell torn by an
+   update is redrawn at the next one */
+static volatile uint16_t text_want[TEXT_ROWS][TEXT_COLS];
+/* On the panel, display thread only */
+static uint16_t text_drawn[TEXT_ROWS][TEXT_COLS];
+
+static uint16_t text_glyphs[TEXT_CACHE_GLYPHS][TEXT_CELL_PIXELS];
+static uint16_t text_keys[TEXT_CACHE_GLYPHS];
+static uint32_t text_used[TEXT_CACHE_GLYPHS];
+static uint32_t text_clock;
+
+static const TEXT_ColoursTypeDef text_palette[TEXT_ATTRS] = {
+    { DISP_WHITE, DISP_BLACK },
+    { DISP_BLACK, DISP_WHITE },
+    { DISP_RGB(255, 255, 0), DISP_RGB(192, 0, 0) },
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static void TEXT_Update(uint8_t full);
+static const uint16_t *TEXT_Glyph(uint16_t cell);
+
+/**
+  * @brief  Blank the text band and register its update with the display.
+  * @note   Must run from tx_application_define, after DISP_Init.
+  * @retval ThreadX status
+  */
+UINT TEXT_Init(void)
+{
+    uint32_t row, col, i;
+
+    for (row = 0; row < TEXT_ROWS; row++) {
+        for (col = 0; col < TEXT_COLS; col++) {
+            text_want[row][col]  = TEXT_CELL(' ', TEXT_NORMAL);
+            text_drawn[row][col] = TEXT_STALE;
+        }
+    }
+    for (i = 0; i < TEXT_CACHE_GLYPHS; i++) {
+        text_keys[i] = TEXT_STALE;
+        text_used[i] = 0;
+    }
+    text_clock = 0;
+    return DISP_AddUpdate(TEXT_Update);
+}
+
+/**
+  * @brief  Write a string into the band, clipped at the end of the row.
+  * @note   Any thread; the cells that changed are drawn at the next update.
+  * @param  row, col : first cell
+  * @param  s : characters outside ' ' to '~' show as '?'
+  * @param  attr : TEXT_NORMAL, TEXT_INVERSE or TEXT_ALARM
+  * @retval None
+  */
+void TEXT_Print(uint32_t row, uint32_t col, const char *s, uint8_t attr)
+{
+    char c;
+
+    if (row >= TEXT_ROWS || attr >= TEXT_ATTRS) {
+        return;
+    }
+    for (; *s != '\0' && col < TEXT_COLS; s++, col++) {
+        c = *s;
+        if (c < TEXT_FIRST_CHAR || c > TEXT_LAST_CHAR) {
+            c = '?';
+        }
+        text_want[row][col] = TEXT_CELL(c, attr);
+    }
+    DISP_Update();
+}
+
+/**
+  * @brief  Write a decimal number right-aligned in a field of spaces.
+  * @note   Any thread. A number wider than the field shows as #s.
+  * @param  row, col : first cell of the field
+  * @param  value : number
+  * @param  width : field width, 1 to 11
+  * @param  attr : TEXT_NORMAL, TEXT_INVERSE or TEXT_ALARM
+  * @retval None
+  */
+void TEXT_Number(uint32_t row, uint32_t col, int32_t value, uint32_t width, uint8_t attr)
+{
+    char field[12];
+    uint32_t magnitude, i;
+
+    if (width == 0U) {
+        return;
+    }
+    if (width > sizeof(field) - 1U) {
+        width = sizeof(field) - 1U;
+    }
+    magnitude = (value < 0) ? 0U - (uint32_t)value : (uint32_t)value;
+    field[width] = '\0';
+    i = width;
+    do {
+        field[--i] = (char)('0' + magnitude % 10U);
+        magnitude /= 10U;
+    } while (magnitude != 0U && i > 0U);
+    if (magnitude != 0U || (value < 0 && i == 0U)) {
+        for (i = 0; i < width; i++) {
+            field[i] = '#';
+        }
+        i = 0;
+    } else if (value < 0) {
+        field[--i] = '-';
+    }
+    while (i > 0U) {
+        field[--i] = ' ';
+    }
+    TEXT_Print(row, col, field, attr);
+}
+
+/* Display thread: send the cells that are not as wanted */
+static void TEXT_Update(uint8_t full)
+{
+    uint32_t row, col;
+    uint16_t cell;
+
+    for (row = 0; row < TEXT_ROWS; row++) {
+        for (col = 0; col < TEXT_COLS; col++) {
+            cell = text_want[row][col];
+            if (!full && cell == text_drawn[row][col]) {
+                continue;
+            }
+            DISP_Blit((uint16_t)(col * TEXT_CELL_WIDTH), (uint16_t)(row * TEXT_CELL_HEIGHT),
+                      TEXT_CELL_WIDTH, TEXT_CELL_HEIGHT, TEXT_Glyph(cell));
+            text_drawn[row][col] = cell;
+        }
+    }
+}
+
+/* The cache entry of a cell, expanded into the least recently used one if
+   missing. That is never the entry of the previous DISP_Blit, which may
+   still be going out: it is the most recently used. */
+static const uint16_t *TEXT_Glyph(uint16_t cell)
+{
+    const TEXT_ColoursTypeDef *colours = &text_palette[cell >> 8];
+    const uint8_t *bits;
+    uint16_t *pixels;
+    uint32_t i, victim = 0, x, y;
+
+    text_clock++;
+    for (i = 0; i < TEXT_CACHE_GLYPHS; i++) {
+        if (text_keys[i] == cell) {
+            text_used[i] = text_clock;
+            return text_glyphs[i];
+        }
+        if (text_used[i] < text_used[victim]) {
+            victim = i;
+        }
+    }
+
+    bits   = &TEXT_FONT.table[((cell & 0xFFU) - TEXT_FIRST_CHAR) * TEXT_CELL_HEIGHT];
+    pixels = text_glyphs[victim];
+    for (y = 0; y < TEXT_CELL_HEIGHT; y++) {
+        for (x = 0; x < TEXT_CELL_WIDTH; x++) {
+            *pixels++ = (bits[y] & (0x80U >> x)) ? colours->fg : colours->bg;
+        }
+    }
+    text_keys[victim] = cell;
+    text_used[victim] = text_clock;
+    return text_glyphs[victim];
+}
+
+#endif /* USE_DISPLAY */
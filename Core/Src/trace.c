@@ -0,0 +1,203 @@
+/**
+  ******************************************************************************
+  * @file    trace.c
+  * @brief   ThreadX event trace, streamed to the host for TraceX.
+  *          With TX_ENABLE_EVENT_TRACE the kernel logs thread, queue,
+  *          semaphore and mutex activity, and the interrupt handlers their
+  *          entry and exit, into a small ring in RAM. A thread at the lowest
+  *          priority drains the ring into STREAM_TYPE_TRACE packets on the
+  *          stream UART, a few packets at a time and only while the stream
+  *          has little queued, so samples always go first. Entries the ring
+  *          overwrites before they are sent are counted in trace_lost; the
+  *          running entry numbers in the packets show the host where.
+  *          stream_parser.py --trace rebuilds a TraceX file from the
+  *          header, the registry and the entries.
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "trace.h"
+#include "stream.h"
+#include "usart.h"
+#include "lowpower.h"
+
+#ifdef TX_ENABLE_EVENT_TRACE
+
+#include "tx_trace.h"
+
+/* Private variables ---------------------------------------------------------*/
+static TX_THREAD trace_thread;
+static uint8_t trace_thread_stack[TRACE_STACK_SIZE];
+/* ULONG for the alignment ThreadX expects */
+static ULONG trace_area[TRACE_AREA_SIZE / sizeof(ULONG)];
+/* Kept off the trace thread's stack */
+static uint8_t trace_packet[STREAM_HEADER_SIZE + TRACE_EVENTS_HEADER +
+                            TRACE_EVENTS_MAX * TRACE_ENTRY_SIZE + STREAM_CRC_SIZE];
+/* Entries in the ring */
+static uint32_t trace_entries;
+/* Times the ring has wrapped */
+static volatile uint32_t trace_wraps;
+/* Running number of the next entry to send */
+static uint32_t trace_next;
+
+volatile uint32_t trace_lost;
+
+/* Private function prototypes -----------------------------------------------*/
+static void TRACE_Thread(ULONG thread_input);
+static VOID TRACE_Wrapped(VOID *buffer);
+static void TRACE_SendImage(void);
+static uint16_t TRACE_Events(uint8_t *payload);
+
+static inline void TRACE_Put16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+/* Running number of the entry ThreadX writes next; interrupts disabled */
+static inline uint32_t TRACE_Head(void)
+{
+    return trace_wraps * trace_entries + (uint32_t)(_tx_trace_buffer_current_ptr - _tx_trace_buffer_start_ptr);
+}
+
+/**
+  * @brief  Start the event trace and create the trace thread.
+  * @note   Call early in tx_application_define; objects created before
+  *         are registered too, but only TRACE_REGISTRY_ENTRIES of them.
+  * @retval ThreadX status
+  */
+UINT TRACE_Init(void)
+{
+    UINT status;
+
+    trace_wraps = 0;
+    trace_next  = 0;
+    trace_lost  = 0;
+
+    status = tx_trace_enable(trace_area, sizeof(trace_area), TRACE_REGISTRY_ENTRIES);
+    if (status == TX_SUCCESS) {
+        status = tx_trace_buffer_full_notify(TRACE_Wrapped);
+    }
+    if (status != TX_SUCCESS) {
+        return status;
+    }
+    trace_entries = (uint32_t)(_tx_trace_buffer_end_ptr - _tx_trace_buffer_start_ptr);
+
+    return tx_thread_create(&trace_thread, "trace thread", TRACE_Thread, 0,
+                            trace_thread_stack, TRACE_STACK_SIZE,
+                            TRACE_PRIORITY, TRACE_PRIORITY, TX_NO_TIME_SLICE, TX_AUTO_START);
+}
+
+/**
+  * @brief  Trace time stamp, TX_TRACE_TIME_SOURCE, in core clock cycles.
+  * @note   The Cortex-M0+ has no cycle counter and the 16-bit TIM3 wraps
+  *         every 2 ms, too often for the gaps between events. ThreadX
+  *         calls this with interrupts disabled, as LP_Cycles needs.
+  * @retval Time stamp
+  */
+ULONG TRACE_Time(VOID)
+{
+    return LP_Cycles();
+}
+
+static void TRACE_Thread(ULONG thread_input)
+{
+    ULONG imaged;
+    uint32_t burst;
+    uint16_t length;
+
+    TRACE_SendImage();
+    imaged = tx_time_get();
+    for (;;) {
+        tx_thread_sleep(TRACE_PERIOD);
+        if (UART_TX_Pending(&uart_tx_stdout) > TRACE_PENDING_MAX) {
+            continue;
+        }
+        if ((ULONG)(tx_time_get() - imaged) >= TRACE_IMAGE_PERIOD) {
+            TRACE_SendImage();
+            imaged = tx_time_get();
+        }
+        for (burst = 0; burst < TRACE_BURST; burst++) {
+            length = TRACE_Events(&trace_packet[STREAM_HEADER_SIZE]);
+            if (length == 0U) {
+                break;
+            }
+            STREAM_SendPacket(STREAM_TYPE_TRACE, trace_packet, length);
+        }
+    }
+}
+
+/* From the insert that wrapped the ring, interrupts disabled */
+static VOID TRACE_Wrapped(VOID *buffer)
+{
+    trace_wraps++;
+}
+
+/* Header and registry; object creation may change the registry meanwhile,
+   the next repeat has it */
+static void TRACE_SendImage(void)
+{
+    const uint8_t *area = (const uint8_t *)trace_area;
+    uint8_t *payload    = &trace_packet[STREAM_HEADER_SIZE];
+    uint32_t size       = (uint32_t)((const uint8_t *)_tx_trace_buffer_start_ptr - area);
+    uint32_t offset, n;
+
+    for (offset = 0; offset < size; offset += n) {
+        n = size - offset;
+        if (n > TRACE_IMAGE_CHUNK) {
+            n = TRACE_IMAGE_CHUNK;
+        }
+        payload[0] = TRACE_KIND_IMAGE;
+        payload[1] = 0;
+        TRACE_Put16(&payload[2], (uint16_t)offset);
+        memcpy(&payload[TRACE_IMAGE_HEADER], &area[offset], n);
+        STREAM_SendPacket(STREAM_TYPE_TRACE, trace_packet, (uint16_t)(TRACE_IMAGE_HEADER + n));
+    }
+}
+
+/* Fill an events payload with the oldest unsent entries; 0 when there are none */
+static uint16_t TRACE_Events(uint8_t *payload)
+{
+    TX_INTERRUPT_SAVE_AREA
+    uint32_t pending, first, n;
+    uint32_t index;
+
+    TX_DISABLE
+    pending = TRACE_Head() - trace_next;
+    if (pending > trace_entries) {
+        /* Overwritten: carry on from the oldest entry still in the ring */
+        trace_lost += pending - trace_entries;
+        trace_next += pending - trace_entries;
+    }
+    TX_RESTORE
+
+    first = trace_next;
+    index = trace_next % trace_entries;
+    for (n = 0; n < TRACE_EVENTS_MAX; n++) {
+        TX_DISABLE
+        pending = TRACE_Head() - trace_next;
+        if (pending == 0U || pending > trace_entries) {
+            /* All sent, or the ring caught up with us: the next call counts the loss */
+            TX_RESTORE
+            break;
+        }
+        memcpy(&payload[TRACE_EVENTS_HEADER + n * TRACE_ENTRY_SIZE], &_tx_trace_buffer_start_ptr[index], TRACE_ENTRY_SIZE);
+        TX_RESTORE
+
+        trace_next++;
+        if (++index == trace_entries) {
+            index = 0;
+        }
+    }
+    if (n == 0U) {
+        return 0;
+    }
+    payload[0] = TRACE_KIND_EVENTS;
+    payload[1] = (uint8_t)n;
+    TRACE_Put16(&payload[2], 0);
+    TRACE_Put16(&payload[4], (uint16_t)first);
+    TRACE_Put16(&payload[6], (uint16_t)(first >> 16));
+    return (uint16_t)(TRACE_EVENTS_HEADER + n * TRACE_ENTRY_SIZE);
+}
+
+#endif /* TX_ENABLE_EVENT_TRACE */
@@ -0,0 +1,204 @@
+/**
+  ******************************************************************************
+  * @file    uart_tx.c
+  * @brief   Non-blocking UART transmit engine.
+  *          Writers copy into a ring buffer and return; the USART TX DMA
+  *          drains the ring one contiguous run at a time and restarts itself
+  *          from the transfer-complete callback. A thread only blocks, on a
+  *          semaphore, when the ring is full, and restarts an idle DMA every
+  *          UART_TX_RETRY ticks while it waits. Writers outside thread
+  *          context (ISRs, initialisation) never block and drop what does
+  *          not fit. A DMA error drops the run that was in flight.
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "uart_tx.h"
+#include "lowpower.h"
+
+/* Private define ------------------------------------------------------------*/
+#define UART_TX_MAX_PORTS 2U
+
+/* Private variables ---------------------------------------------------------*/
+static UART_TX_HandleTypeDef *uart_tx_ports[UART_TX_MAX_PORTS];
+
+/* Private function prototypes -----------------------------------------------*/
+static void UART_TX_Kick(UART_TX_HandleTypeDef *htx);
+
+/**
+  * @brief  Attach a ring buffer to a UART whose TX DMA is linked in its MSP.
+  * @param  htx : engine handle
+  * @param  huart : UART handle
+  * @param  buf : ring storage
+  * @param  size : ring size in bytes, a power of two
+  * @retval ThreadX status
+  */
+UINT UART_TX_Init(UART_TX_HandleTypeDef *htx, UART_HandleTypeDef *huart, uint8_t *buf, uint16_t size)
+{
+    uint32_t i;
+    UINT status;
+
+    if (huart->hdmatx == NULL || size == 0U || (size & (size - 1U)) != 0U) {
+        return TX_SIZE_ERROR;
+    }
+    status = tx_semaphore_create(&htx->space, "uart tx space", 0);
+    if (status == TX_SUCCESS) {
+        status = tx_mutex_create(&htx->lock, "uart tx lock", TX_INHERIT);
+    }
+    if (status != TX_SUCCESS) {
+        return status;
+    }
+    htx->huart    = huart;
+    htx->mask     = size - 1U;
+    htx->head     = 0;
+    htx->tail     = 0;
+    htx->inflight = 0;
+    htx->dropped  = 0;
+    htx->buf      = buf;
+    htx->idle     = NULL;
+
+    for (i = 0; i < UART_TX_MAX_PORTS; i++) {
+        if (uart_tx_ports[i] == NULL || uart_tx_ports[i]->huart == huart) {
+            uart_tx_ports[i] = htx;
+            return TX_SUCCESS;
+        }
+    }
+    return TX_SIZE_ERROR;
+}
+
+/**
+  * @brief  Queue a buffer for transmission.
+  * @note   From a thread this waits for room and returns len; bytes from
+  *         one call are never interleaved with another thread's. From any
+  *         other context it returns the number of bytes that fitted.
+  * @param  htx : engine handle
+  * @param  data : bytes to send
+  * @param  len : number of bytes
+  * @retval Number of bytes queued
+  */
+uint32_t UART_TX_Write(UART_TX_HandleTypeDef *htx, const uint8_t *data, uint32_t len)
+{
+    TX_INTERRUPT_SAVE_AREA
+    uint32_t done = 0;
+    uint16_t n, i;
+    int in_thread = (__get_IPSR() == 0U) && (tx_thread_identify() != TX_NULL);
+
+    if (in_thread) {
+        tx_mutex_get(&htx->lock, TX_WAIT_FOREVER);
+    }
+    while (done < len) {
+        TX_DISABLE
+        n = (uint16_t)(htx->mask + 1U - (uint16_t)(htx->head - htx->tail));
+        if (n > len - done) n = (uint16_t)(len - done);
+        if (n > UART_TX_CHUNK) n = UART_TX_CHUNK;
+        for (i = 0; i < n; i++) {
+            htx->buf[(uint16_t)(htx->head + i) & htx->mask] = data[done + i];
+        }
+        htx->head += n;
+        TX_RESTORE
+
+        done += n;
+        UART_TX_Kick(htx);
+        if (n == 0U) {
+            if (!in_thread) {
+                htx->dropped += len - done;
+                break;
+            }
+            /* Bounded: a refused start leaves nothing in flight to put it */
+            tx_semaphore_get(&htx->space, UART_TX_RETRY);
+        }
+    }
+    if (in_thread) {
+        tx_mutex_put(&htx->lock);
+    }
+    return done;
+}
+
+/**
+  * @brief  Bytes queued or on the wire.
+  * @param  htx : engine handle
+  * @retval Byte count
+  */
+uint32_t UART_TX_Pending(const UART_TX_HandleTypeDef *htx)
+{
+    return (uint16_t)(htx->head - htx->tail);
+}
+
+/* Start the DMA on the next contiguous run if it is idle */
+static void UART_TX_Kick(UART_TX_HandleTypeDef *htx)
+{
+    TX_INTERRUPT_SAVE_AREA
+    uint16_t pending, start, len;
+
+    TX_DISABLE
+    pending = (uint16_t)(htx->head - htx->tail);
+    if (htx->inflight == 0U && pending != 0U) {
+        start = htx->tail & htx->mask;
+        len   = (uint16_t)(htx->mask + 1U - start);
+        if (len > pending) len = pending;
+        htx->inflight = len;
+        if (HAL_UART_Transmit_DMA(htx->huart, &htx->buf[start], len) != HAL_OK) {
+            /* Someone is using the port in blocking mode, retry on the next
+               write or when a blocked writer's wait runs out */
+            htx->inflight = 0;
+        } else {
+            /* Released on completion, STOP1 would halt the USART mid-frame */
+            LP_Hold();
+        }
+    }
+    TX_RESTORE
+}
+
+/**
+  * @brief  Tx Transfer completed callback.
+  * @param  huart : UART handle
+  * @retval None
+  */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    UART_TX_HandleTypeDef *htx;
+    uint32_t i;
+
+    for (i = 0; i < UART_TX_MAX_PORTS; i++) {
+        htx = uart_tx_ports[i];
+        if (htx != NULL && htx->huart == huart) {
+            htx->tail += htx->inflight;
+            htx->inflight = 0;
+            LP_Release();
+            UART_TX_Kick(htx);
+            if (htx->inflight == 0U && htx->idle != NULL) {
+                htx->idle(huart);
+            }
+            tx_semaphore_ceiling_put(&htx->space, 1);
+            break;
+        }
+    }
+}
+
+/**
+  * @brief  Transmit side of HAL_UART_ErrorCallback.
+  * @note   A DMA error ends the transfer with the port READY; the run in
+  *         flight is counted as dropped rather than sent again, since a bus
+  *         error would only recur, and the rest of the ring is restarted.
+  * @param  huart : UART handle
+  * @retval None
+  */
+void UART_TX_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    UART_TX_HandleTypeDef *htx;
+    uint32_t i;
+
+    for (i = 0; i < UART_TX_MAX_PORTS; i++) {
+        htx = uart_tx_ports[i];
+        if (htx != NULL && htx->huart == huart) {
+            if (htx->inflight != 0U && huart->gState == HAL_UART_STATE_READY) {
+                htx->tail += htx->inflight;
+                htx->dropped += htx->inflight;
+                htx->inflight = 0;
+                LP_Release();
+                UART_TX_Kick(htx);
+                tx_semaphore_ceiling_put(&htx->space, 1);
+            }
+            break;
+        }
+    }
+}
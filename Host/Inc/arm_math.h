@@ -0,0 +1,65 @@
+/**
+  ******************************************************************************
+  * @file    arm_math.h
+  * @brief   Host stand-in for the CMSIS-DSP header.
+  *          Only what the application uses on the host, with the types and
+  *          prototypes of the bundled arm_math.h; sim_dsp.c has plain C
+  *          versions of the kernels.
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef _ARM_MATH_H
+#define _ARM_MATH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported types ------------------------------------------------------------*/
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+typedef int64_t q63_t;
+
+typedef enum {
+    ARM_MATH_SUCCESS        = 0,
+    ARM_MATH_ARGUMENT_ERROR = -1,
+    ARM_MATH_LENGTH_ERROR   = -2
+} arm_status;
+
+typedef struct {
+    int8_t numStages;
+    q15_t *pState;
+    q15_t *pCoeffs;
+    int8_t postShift;
+} arm_biquad_casd_df1_inst_q15;
+
+typedef struct {
+    uint8_t M;
+    uint16_t numTaps;
+    q15_t *pCoeffs;
+    q15_t *pState;
+} arm_fir_decimate_instance_q15;
+
+/* Exported functions --------------------------------------------------------*/
+static inline q15_t clip_q31_to_q15(q31_t x)
+{
+    return ((q31_t)(x >> 16) != ((q31_t)x >> 15)) ? (q15_t)(0x7FFF ^ (q15_t)(x >> 31)) : (q15_t)x;
+}
+
+void arm_biquad_cascade_df1_init_q15(arm_biquad_casd_df1_inst_q15 *S, uint8_t numStages,
+                                     q15_t *pCoeffs, q15_t *pState, int8_t postShift);
+void arm_biquad_cascade_df1_fast_q15(const arm_biquad_casd_df1_inst_q15 *S,
+                                     q15_t *pSrc, q15_t *pDst, uint32_t blockSize);
+arm_status arm_fir_decimate_init_q15(arm_fir_decimate_instance_q15 *S, uint16_t numTaps,
+                                     uint8_t M, q15_t *pCoeffs, q15_t *pState, uint32_t blockSize);
+void arm_fir_decimate_fast_q15(const arm_fir_decimate_instance_q15 *S,
+                               q15_t *pSrc, q15_t *pDst, uint32_t blockSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ARM_MATH_H */
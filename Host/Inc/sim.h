@@ -0,0 +1,53 @@
+/**
+  ******************************************************************************
+  * @file    sim.h
+  * @brief   This file contains all the function prototypes for
+  *          the host simulator (sim_*.c)
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SIM_H__
+#define __SIM_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include "stm32g0xx_hal.h"
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct {
+    const char *input;     /* CSV of x,y,z[,vref] ADC codes, NULL for synthetic data */
+    double rate;           /* TIM1 speed-up over the 1 kHz of the target */
+    double seconds;        /* stop after this much wall time, 0 runs forever */
+    int wire_time;         /* hold each UART DMA transfer for its time on the wire */
+} SIM_ConfigTypeDef;
+
+typedef struct {
+    volatile uint64_t frames;    /* ADC frames written by the simulated DMA */
+    volatile uint64_t irqs;      /* simulated interrupts raised */
+    volatile uint64_t uart_bytes[2];
+    volatile uint64_t spi_bytes;
+} SIM_StatsTypeDef;
+
+/* Exported variables --------------------------------------------------------*/
+extern SIM_ConfigTypeDef sim_config;
+extern SIM_StatsTypeDef sim_stats;
+/* SIM_Now of the last simulated TIM1 update, see sim_adc.c */
+extern volatile double sim_adc_trigger;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void SIM_IsrEnter(void);
+void SIM_IsrExit(void);
+void SIM_Sleep(double seconds);
+double SIM_Now(void);
+
+void SIM_UART_Init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SIM_H__ */
@@ -0,0 +1,91 @@
+/**
+  ******************************************************************************
+  * @file    stm32g0xx.h
+  * @brief   Host stand-in for the CMSIS device header.
+  *          Peripheral instances are opaque tokens the simulator compares
+  *          against; there are no registers. Interrupt context is whatever
+  *          the ThreadX Linux port says it is.
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __STM32G0XX_H
+#define __STM32G0XX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <stdint.h>
+#include "tx_api.h"
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum {
+    DISABLE = 0,
+    ENABLE  = !DISABLE
+} FunctionalState;
+
+typedef enum {
+    RESET = 0,
+    SET   = !RESET
+} FlagStatus;
+
+typedef struct {
+    const char *name;
+} SIM_PeriphTypeDef;
+
+typedef SIM_PeriphTypeDef ADC_TypeDef;
+typedef SIM_PeriphTypeDef CRC_TypeDef;
+typedef SIM_PeriphTypeDef DMA_Channel_TypeDef;
+typedef SIM_PeriphTypeDef GPIO_TypeDef;
+typedef SIM_PeriphTypeDef SPI_TypeDef;
+typedef SIM_PeriphTypeDef TIM_TypeDef;
+typedef SIM_PeriphTypeDef USART_TypeDef;
+
+/* Exported constants --------------------------------------------------------*/
+extern SIM_PeriphTypeDef sim_adc1, sim_crc, sim_gpioa, sim_gpiob, sim_gpioc;
+extern SIM_PeriphTypeDef sim_spi1, sim_tim1, sim_tim2, sim_tim3, sim_usart1, sim_usart2;
+
+#define ADC1   (&sim_adc1)
+#define CRC    (&sim_crc)
+#define GPIOA  (&sim_gpioa)
+#define GPIOB  (&sim_gpiob)
+#define GPIOC  (&sim_gpioc)
+#define SPI1   (&sim_spi1)
+#define TIM1   (&sim_tim1)
+#define TIM2   (&sim_tim2)
+#define TIM3   (&sim_tim3)
+#define USART1 (&sim_usart1)
+#define USART2 (&sim_usart2)
+
+#define USART_ISR_PE   (0x1UL << 0)
+#define USART_ISR_FE   (0x1UL << 1)
+#define USART_ISR_NE   (0x1UL << 2)
+#define USART_ISR_ORE  (0x1UL << 3)
+#define USART_ISR_IDLE (0x1UL << 4)
+#define USART_ISR_TC   (0x1UL << 6)
+
+#define TIM_SR_CC2IF   (0x1UL << 2)
+#define TIM_DIER_CC2IE (0x1UL << 2)
+
+/* Exported functions --------------------------------------------------------*/
+/* Non-zero inside a simulated ISR or before the scheduler starts */
+extern volatile ULONG _tx_thread_system_state;
+
+static inline uint32_t __get_IPSR(void)
+{
+    return (_tx_thread_system_state != 0U) ? 1U : 0U;
+}
+
+/* There is no system stack of the firmware's to look at */
+static inline uint32_t __get_MSP(void)
+{
+    return 0U;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STM32G0XX_H */
@@ -0,0 +1,239 @@
+/**
+  ******************************************************************************
+  * @file    stm32g0xx_hal.h
+  * @brief   Host stand-in for the subset of the STM32G0 HAL the application
+  *          modules use. Handles keep the field names of the real HAL so
+  *          the firmware sources compile unchanged; sim_*.c implement the
+  *          functions on top of POSIX.
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __STM32G0XX_HAL_H
+#define __STM32G0XX_HAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32g0xx.h"
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum {
+    HAL_OK      = 0x00U,
+    HAL_ERROR   = 0x01U,
+    HAL_BUSY    = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum {
+    GPIO_PIN_RESET = 0U,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef enum {
+    HAL_UART_STATE_READY   = 0x20U,
+    HAL_UART_STATE_BUSY_TX = 0x21U
+} HAL_UART_StateTypeDef;
+
+typedef struct {
+    DMA_Channel_TypeDef *Instance;
+} DMA_HandleTypeDef;
+
+typedef struct {
+    uint32_t Ratio;
+    uint32_t RightBitShift;
+    uint32_t TriggeredMode;
+} ADC_OversamplingTypeDef;
+
+typedef struct {
+    FunctionalState OversamplingMode;
+    ADC_OversamplingTypeDef Oversampling;
+} ADC_InitTypeDef;
+
+typedef struct {
+    ADC_TypeDef *Instance;
+    ADC_InitTypeDef Init;
+    DMA_HandleTypeDef *DMA_Handle;
+    volatile uint32_t ErrorCode;
+} ADC_HandleTypeDef;
+
+typedef struct {
+    uint32_t Prescaler;
+    uint32_t Period;
+} TIM_Base_InitTypeDef;
+
+typedef struct {
+    TIM_TypeDef *Instance;
+    TIM_Base_InitTypeDef Init;
+    volatile uint32_t sr;   /* TIMx_SR, TIMx_DIER and TIMx_CCR2 */
+    volatile uint32_t dier;
+    volatile uint32_t ccr2;
+} TIM_HandleTypeDef;
+
+typedef struct {
+    uint32_t DataSize;
+} SPI_InitTypeDef;
+
+typedef struct {
+    SPI_TypeDef *Instance;
+    SPI_InitTypeDef Init;
+    DMA_HandleTypeDef *hdmatx;
+} SPI_HandleTypeDef;
+
+typedef struct {
+    uint32_t BaudRate;
+} UART_InitTypeDef;
+
+typedef struct {
+    USART_TypeDef *Instance;
+    UART_InitTypeDef Init;
+    DMA_HandleTypeDef *hdmatx;
+    DMA_HandleTypeDef *hdmarx;
+    volatile HAL_UART_StateTypeDef gState;
+} UART_HandleTypeDef;
+
+typedef struct {
+    uint32_t GeneratingPolynomial;
+    uint32_t CRCLength;
+    uint32_t InitValue;
+} CRC_InitTypeDef;
+
+typedef struct {
+    CRC_TypeDef *Instance;
+    CRC_InitTypeDef Init;
+} CRC_HandleTypeDef;
+
+/* Exported constants --------------------------------------------------------*/
+#define GPIO_PIN_0  ((uint16_t)0x0001)
+#define GPIO_PIN_1  ((uint16_t)0x0002)
+#define GPIO_PIN_2  ((uint16_t)0x0004)
+#define GPIO_PIN_3  ((uint16_t)0x0008)
+#define GPIO_PIN_4  ((uint16_t)0x0010)
+#define GPIO_PIN_5  ((uint16_t)0x0020)
+#define GPIO_PIN_6  ((uint16_t)0x0040)
+#define GPIO_PIN_7  ((uint16_t)0x0080)
+#define GPIO_PIN_8  ((uint16_t)0x0100)
+#define GPIO_PIN_9  ((uint16_t)0x0200)
+#define GPIO_PIN_10 ((uint16_t)0x0400)
+#define GPIO_PIN_11 ((uint16_t)0x0800)
+#define GPIO_PIN_12 ((uint16_t)0x1000)
+#define GPIO_PIN_13 ((uint16_t)0x2000)
+#define GPIO_PIN_14 ((uint16_t)0x4000)
+#define GPIO_PIN_15 ((uint16_t)0x8000)
+
+#define CRC_POLYLENGTH_16B 0x00000008U
+
+#define SPI_DATASIZE_8BIT  0x00000700U
+#define SPI_DATASIZE_16BIT 0x00000F00U
+
+#define UART_FLAG_IDLE   USART_ISR_IDLE
+#define UART_FLAG_TC     USART_ISR_TC
+#define UART_CLEAR_PEF   USART_ISR_PE
+#define UART_CLEAR_FEF   USART_ISR_FE
+#define UART_CLEAR_NEF   USART_ISR_NE
+#define UART_CLEAR_OREF  USART_ISR_ORE
+#define UART_CLEAR_IDLEF USART_ISR_IDLE
+#define UART_IT_PE       0x0028U
+#define UART_IT_IDLE     0x0424U
+#define UART_IT_TC       0x0626U
+#define UART_IT_ERR      0x0060U
+
+#define TIM_CHANNEL_2 0x00000004U
+#define TIM_FLAG_CC2  TIM_SR_CC2IF
+#define TIM_IT_CC2    TIM_DIER_CC2IE
+
+/* ADC_CFGR2 OVSR and OVSS field values, as on the target */
+#define ADC_OVERSAMPLING_RATIO_2   (0x0UL << 2)
+#define ADC_OVERSAMPLING_RATIO_4   (0x1UL << 2)
+#define ADC_OVERSAMPLING_RATIO_8   (0x2UL << 2)
+#define ADC_OVERSAMPLING_RATIO_16  (0x3UL << 2)
+#define ADC_OVERSAMPLING_RATIO_32  (0x4UL << 2)
+#define ADC_OVERSAMPLING_RATIO_64  (0x5UL << 2)
+#define ADC_OVERSAMPLING_RATIO_128 (0x6UL << 2)
+#define ADC_OVERSAMPLING_RATIO_256 (0x7UL << 2)
+#define ADC_RIGHTBITSHIFT_NONE     (0x0UL << 5)
+#define ADC_RIGHTBITSHIFT_1        (0x1UL << 5)
+#define ADC_RIGHTBITSHIFT_2        (0x2UL << 5)
+#define ADC_RIGHTBITSHIFT_3        (0x3UL << 5)
+#define ADC_RIGHTBITSHIFT_4        (0x4UL << 5)
+#define ADC_TRIGGEREDMODE_SINGLE_TRIGGER 0x0UL
+
+#define HAL_ADC_ERROR_OVR 0x02U
+
+/* Factory VREFINT calibration, read from sim_adc.c instead of system memory */
+#define VREFINT_CAL_ADDR (&sim_vrefint_cal)
+#define VREFINT_CAL_VREF (3000UL)
+
+/* Exported macro ------------------------------------------------------------*/
+/* The simulated TIM1 paces the frames from Init.Period and counts from the
+   last one; TIM1 and TIM2 run rate times faster than the host clock, the
+   other timers free-run from it at 64 MHz / (PSC + 1) */
+#define __HAL_TIM_SET_AUTORELOAD(__HANDLE__, __AUTORELOAD__) ((__HANDLE__)->Init.Period = (__AUTORELOAD__))
+#define __HAL_TIM_GET_AUTORELOAD(__HANDLE__)                 ((__HANDLE__)->Init.Period)
+#define __HAL_TIM_SET_COUNTER(__HANDLE__, __COUNTER__)       ((void)(__HANDLE__), (void)(__COUNTER__))
+#define __HAL_TIM_GET_COUNTER(__HANDLE__)                    SIM_TIM_GetCounter(__HANDLE__)
+/* Of the compare channels only TIM2 channel 2 is simulated, see sim_main.c */
+#define __HAL_TIM_SET_COMPARE(__HANDLE__, __CHANNEL__, __COMPARE__) SIM_TIM_SetCompare((__HANDLE__), (__COMPARE__))
+#define __HAL_TIM_ENABLE_IT(__HANDLE__, __INTERRUPT__)       SIM_TIM_EnableIT((__HANDLE__), (__INTERRUPT__))
+#define __HAL_TIM_DISABLE_IT(__HANDLE__, __INTERRUPT__)      ((__HANDLE__)->dier &= ~(__INTERRUPT__))
+#define __HAL_TIM_GET_IT_SOURCE(__HANDLE__, __INTERRUPT__)   ((((__HANDLE__)->dier & (__INTERRUPT__)) == (__INTERRUPT__)) ? SET : RESET)
+#define __HAL_TIM_GET_FLAG(__HANDLE__, __FLAG__)             ((((__HANDLE__)->sr & (__FLAG__)) == (__FLAG__)) ? SET : RESET)
+#define __HAL_TIM_CLEAR_FLAG(__HANDLE__, __FLAG__)           ((__HANDLE__)->sr &= ~(__FLAG__))
+
+/* USART status flags and the RX DMA counter live in sim_uart.c */
+#define __HAL_DMA_GET_COUNTER(__HANDLE__)           SIM_DMA_GetCounter(__HANDLE__)
+#define __HAL_UART_GET_FLAG(__HANDLE__, __FLAG__)   SIM_UART_GetFlag((__HANDLE__), (__FLAG__))
+#define __HAL_UART_CLEAR_FLAG(__HANDLE__, __FLAG__) SIM_UART_ClearFlag((__HANDLE__), (__FLAG__))
+/* The idle line and transmission complete are the only simulated
+   interrupts and are always on */
+#define __HAL_UART_ENABLE_IT(__HANDLE__, __INTERRUPT__)     ((void)(__HANDLE__), (void)(__INTERRUPT__))
+#define __HAL_UART_DISABLE_IT(__HANDLE__, __INTERRUPT__)    ((void)(__HANDLE__), (void)(__INTERRUPT__))
+#define __HAL_UART_GET_IT_SOURCE(__HANDLE__, __INTERRUPT__) ((void)(__HANDLE__), (void)(__INTERRUPT__), SET)
+
+/* Exported variables --------------------------------------------------------*/
+extern const uint16_t sim_vrefint_cal;
+
+/* Exported functions prototypes ---------------------------------------------*/
+uint32_t SIM_DMA_GetCounter(const DMA_HandleTypeDef *hdma);
+uint32_t SIM_TIM_GetCounter(const TIM_HandleTypeDef *htim);
+void SIM_TIM_SetCompare(TIM_HandleTypeDef *htim, uint32_t compare);
+void SIM_TIM_EnableIT(TIM_HandleTypeDef *htim, uint32_t it);
+FlagStatus SIM_UART_GetFlag(const UART_HandleTypeDef *huart, uint32_t flag);
+void SIM_UART_ClearFlag(const UART_HandleTypeDef *huart, uint32_t flag);
+
+uint32_t HAL_GetTick(void);
+
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef *htim);
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+
+HAL_StatusTypeDef HAL_ADC_Init(ADC_HandleTypeDef *hadc);
+HAL_StatusTypeDef HAL_ADC_Start_DMA(ADC_HandleTypeDef *hadc, uint32_t *pData, uint32_t Length);
+HAL_StatusTypeDef HAL_ADC_Stop_DMA(ADC_HandleTypeDef *hadc);
+uint32_t HAL_ADC_GetError(ADC_HandleTypeDef *hadc);
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc);
+void HAL_ADC_ErrorCallback(ADC_HandleTypeDef *hadc);
+
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef *hspi);
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_SPI_Abort(SPI_HandleTypeDef *hspi);
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi);
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi);
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_AbortTransmit(UART_HandleTypeDef *huart);
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart);
+
+uint32_t HAL_CRC_Calculate(CRC_HandleTypeDef *hcrc, uint32_t pBuffer[], uint32_t BufferLength);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STM32G0XX_HAL_H */
@@ -0,0 +1,257 @@
+/**
+  ******************************************************************************
+  * @file    sim_adc.c
+  * @brief   ADC1 + DMA1_Channel1 + TIM1 trigger, simulated.
+  *          A pthread plays TIM1: every TIM1 period / rate it converts one
+  *          frame (IN4, IN5, IN6, VREFINT) into the DMA buffer and raises
+  *          the transfer-complete interrupt when it is full. As on the target
+  *          the channel is in normal mode: a frame triggered before
+  *          ADC1_DMA_Rearm points it at the next buffer overruns the ADC
+  *          and raises the error interrupt. Samples are either synthetic - a
+  *          few tones on x and y, 1 g on z, plus noise - or replayed from a
+  *          CSV. With oversampling on, each result is the shifted sum of
+  *          ratio conversions, each with its own noise.
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+#include "sim.h"
+#include "adc.h"
+#include "tim.h"
+#include "latency.h"
+
+/* Private define ------------------------------------------------------------*/
+#define SIM_ADC_CHANNELS 4U
+#define SIM_ADC_MID      2048.0
+#define SIM_ADC_ONE_G    372.0  /* ADXL330 300 mV/g on a 3.3 V, 12-bit ADC */
+#define SIM_ADC_VREFINT  1504U  /* 1.212 V at VDDA = 3.3 V */
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* Exported variables --------------------------------------------------------*/
+/* VREFINT_CAL: 1.212 V at Vref+ = 3.0 V */
+const uint16_t sim_vrefint_cal = 1655U;
+
+volatile double sim_adc_trigger;
+
+/* Private variables ---------------------------------------------------------*/
+static pthread_t sim_adc_thread;
+static pthread_mutex_t sim_adc_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sim_adc_run   = PTHREAD_COND_INITIALIZER;
+static int sim_adc_started;
+static volatile int sim_adc_enabled;
+/* Bumped by every start so the thread picks up the new set-up */
+static volatile uint32_t sim_adc_starts;
+static uint16_t *sim_adc_buf;
+static uint32_t sim_adc_len;
+/* Next conversion's place in sim_adc_buf, sim_adc_len once the transfer is done */
+static uint32_t sim_adc_pos;
+
+static uint16_t *sim_adc_replay;
+static uint32_t sim_adc_replay_frames;
+
+/* Private function prototypes -----------------------------------------------*/
+static void SIM_ADC_Load(const char *path);
+static void SIM_ADC_Convert(uint64_t n, double t, uint16_t *frame);
+static void SIM_ADC_Sample(uint64_t n, double t, uint16_t *frame);
+static void *SIM_ADC_Thread(void *arg);
+
+/**
+  * @brief  Nothing to program, the set-up in hadc->Init is read on start.
+  */
+HAL_StatusTypeDef HAL_ADC_Init(ADC_HandleTypeDef *hadc)
+{
+    return (hadc == &hadc1) ? HAL_OK : HAL_ERROR;
+}
+
+/**
+  * @brief  Start DMA of the fixed sequence into pData.
+  * @param  Length : number of conversions, a whole number of frames
+  */
+HAL_StatusTypeDef HAL_ADC_Start_DMA(ADC_HandleTypeDef *hadc, uint32_t *pData, uint32_t Length)
+{
+    if (hadc != &hadc1 || Length == 0U || Length % SIM_ADC_CHANNELS != 0U) {
+        return HAL_ERROR;
+    }
+    pthread_mutex_lock(&sim_adc_lock);
+    sim_adc_buf     = (uint16_t *)pData;
+    sim_adc_len     = Length;
+    sim_adc_pos     = 0;
+    sim_adc_enabled = 1;
+    sim_adc_starts++;
+    hadc->ErrorCode = 0;
+    if (!sim_adc_started) {
+        if (sim_config.input != NULL) {
+            SIM_ADC_Load(sim_config.input);
+        }
+        pthread_create(&sim_adc_thread, NULL, SIM_ADC_Thread, NULL);
+        sim_adc_started = 1;
+    }
+    pthread_cond_signal(&sim_adc_run);
+    pthread_mutex_unlock(&sim_adc_lock);
+    return HAL_OK;
+}
+
+/**
+  * @brief  From adc.c: arm the channel on the next buffer. Only called
+  *         from HAL_ADC_ConvCpltCallback, on the ADC thread itself.
+  */
+HAL_StatusTypeDef ADC1_DMA_Rearm(uint16_t *buf, uint32_t length)
+{
+    if (length == 0U || length % SIM_ADC_CHANNELS != 0U) {
+        return HAL_ERROR;
+    }
+    sim_adc_buf = buf;
+    sim_adc_len = length;
+    sim_adc_pos = 0;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_Stop_DMA(ADC_HandleTypeDef *hadc)
+{
+    if (hadc != &hadc1) {
+        return HAL_ERROR;
+    }
+    sim_adc_enabled = 0;
+    return HAL_OK;
+}
+
+uint32_t HAL_ADC_GetError(ADC_HandleTypeDef *hadc)
+{
+    return hadc->ErrorCode;
+}
+
+static void SIM_ADC_Load(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    unsigned int v[SIM_ADC_CHANNELS];
+    char line[128];
+    uint32_t cap = 0, i;
+
+    if (f == NULL) {
+        perror(path);
+        exit(1);
+    }
+    while (fgets(line, sizeof(line), f) != NULL) {
+        v[3] = SIM_ADC_VREFINT;
+        if (sscanf(line, " %u , %u , %u , %u", &v[0], &v[1], &v[2], &v[3]) < 3) {
+            continue; /* header or comment */
+        }
+        if (sim_adc_replay_frames == cap) {
+            cap            = cap ? 2U * cap : 1024U;
+            sim_adc_replay = realloc(sim_adc_replay, cap * SIM_ADC_CHANNELS * sizeof(uint16_t));
+        }
+        for (i = 0; i < SIM_ADC_CHANNELS; i++) {
+            sim_adc_replay[sim_adc_replay_frames * SIM_ADC_CHANNELS + i] = (uint16_t)(v[i] & 0xFFFU);
+        }
+        sim_adc_replay_frames++;
+    }
+    fclose(f);
+    if (sim_adc_replay_frames == 0U) {
+        fprintf(stderr, "sim: no x,y,z samples in %s\n", path);
+        exit(1);
+    }
+    fprintf(stderr, "sim: replaying %u frames from %s\n", sim_adc_replay_frames, path);
+}
+
+/* Frame n of the input at t seconds, as the four conversion results */
+static void SIM_ADC_Sample(uint64_t n, double t, uint16_t *frame)
+{
+    static unsigned int seed = 1U;
+    uint32_t i;
+
+    if (sim_adc_replay != NULL) {
+        for (i = 0; i < SIM_ADC_CHANNELS; i++) {
+            frame[i] = sim_adc_replay[(n % sim_adc_replay_frames) * SIM_ADC_CHANNELS + i];
+        }
+        return;
+    }
+    frame[0] = (uint16_t)(SIM_ADC_MID + 400.0 * sin(2.0 * M_PI * 50.0 * t) + 150.0 * sin(2.0 * M_PI * 180.0 * t) +
+                          (rand_r(&seed) % 17) - 8);
+    frame[1] = (uint16_t)(SIM_ADC_MID + 250.0 * sin(2.0 * M_PI * 120.0 * t + 1.0) + (rand_r(&seed) % 17) - 8);
+    frame[2] = (uint16_t)(SIM_ADC_MID + SIM_ADC_ONE_G + (rand_r(&seed) % 17) - 8);
+    frame[3] = (uint16_t)(SIM_ADC_VREFINT + (rand_r(&seed) % 3) - 1);
+}
+
+/* One triggered frame: a plain conversion or the oversampler's shifted sum */
+static void SIM_ADC_Convert(uint64_t n, double t, uint16_t *frame)
+{
+    uint32_t sum[SIM_ADC_CHANNELS] = {0};
+    uint16_t one[SIM_ADC_CHANNELS];
+    uint32_t ratio = 1U, shift = 0U, k, i;
+
+    if (hadc1.Init.OversamplingMode == ENABLE) {
+        ratio = 2UL << (hadc1.Init.Oversampling.Ratio >> 2);
+        shift = hadc1.Init.Oversampling.RightBitShift >> 5;
+    }
+    for (k = 0; k < ratio; k++) {
+        SIM_ADC_Sample(n, t, one);
+        for (i = 0; i < SIM_ADC_CHANNELS; i++) {
+            sum[i] += one[i];
+        }
+    }
+    for (i = 0; i < SIM_ADC_CHANNELS; i++) {
+        frame[i] = (uint16_t)(sum[i] >> shift);
+    }
+}
+
+/* TIM1 TRGO2 + ADC1 + DMA1_Channel1 */
+static void *SIM_ADC_Thread(void *arg)
+{
+    struct timespec next;
+    uint64_t n = 0;
+    uint32_t starts = 0;
+    double t = 0.0, period_s = 0.0;
+    long period = 0;
+
+    (void)arg;
+    for (;;) {
+        if (!sim_adc_enabled || starts != sim_adc_starts) {
+            pthread_mutex_lock(&sim_adc_lock);
+            while (!sim_adc_enabled) {
+                pthread_cond_wait(&sim_adc_run, &sim_adc_lock);
+            }
+            starts = sim_adc_starts;
+            pthread_mutex_unlock(&sim_adc_lock);
+            /* TIM1 counts at 1 MHz, the update period is ARR + 1 */
+            period_s = (htim1.Init.Period + 1U) * 1e-6;
+            period   = (long)(1e9 * period_s / sim_config.rate);
+            clock_gettime(CLOCK_MONOTONIC, &next);
+        }
+
+        next.tv_nsec += period;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+        sim_adc_trigger = (double)next.tv_sec + (double)next.tv_nsec * 1e-9;
+
+        t += period_s;
+        n++;
+        if (sim_adc_pos == sim_adc_len) {
+            /* Channel not armed again: the result stays in DR */
+            hadc1.ErrorCode |= HAL_ADC_ERROR_OVR;
+            SIM_IsrEnter();
+            HAL_ADC_ErrorCallback(&hadc1);
+            SIM_IsrExit();
+            continue;
+        }
+        SIM_ADC_Convert(n - 1U, t - period_s, &sim_adc_buf[sim_adc_pos]);
+        sim_adc_pos += SIM_ADC_CHANNELS;
+        sim_stats.frames++;
+
+        if (sim_adc_pos == sim_adc_len) {
+            SIM_IsrEnter();
+            LAT_ISR_ENTER();
+            HAL_ADC_ConvCpltCallback(&hadc1);
+            SIM_IsrExit();
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,81 @@
+/**
+  ******************************************************************************
+  * @file    sim_dsp.c
+  * @brief   CMSIS-DSP kernels for the host build.
+  *          The target links the prebuilt M0 library, which does not run on
+  *          the host. These follow the fast q15 kernels: 32-bit accumulators,
+  *          state and coefficient layouts as in arm_math.h, results
+  *          saturated to q15.
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "arm_math.h"
+
+void arm_biquad_cascade_df1_init_q15(arm_biquad_casd_df1_inst_q15 *S, uint8_t numStages,
+                                     q15_t *pCoeffs, q15_t *pState, int8_t postShift)
+{
+    S->numStages = (int8_t)numStages;
+    S->pCoeffs   = pCoeffs;
+    S->pState    = pState;
+    S->postShift = postShift;
+    memset(pState, 0, 4U * numStages * sizeof(q15_t));
+}
+
+/* { b0, 0, b1, b2, a1, a2 } and { x[n-1], x[n-2], y[n-1], y[n-2] } per stage */
+void arm_biquad_cascade_df1_fast_q15(const arm_biquad_casd_df1_inst_q15 *S,
+                                     q15_t *pSrc, q15_t *pDst, uint32_t blockSize)
+{
+    const q15_t *c = S->pCoeffs;
+    q15_t *st = S->pState, *src = pSrc;
+    int32_t acc;
+    q15_t y;
+    int stage;
+    uint32_t i;
+
+    for (stage = 0; stage < S->numStages; stage++, c += 6, st += 4) {
+        for (i = 0; i < blockSize; i++) {
+            acc = c[0] * src[i] + c[2] * st[0] + c[3] * st[1] + c[4] * st[2] + c[5] * st[3];
+            y = clip_q31_to_q15(acc >> (15 - S->postShift));
+            st[1] = st[0];
+            st[0] = src[i];
+            st[3] = st[2];
+            st[2] = y;
+            pDst[i] = y;
+        }
+        src = pDst;
+    }
+}
+
+arm_status arm_fir_decimate_init_q15(arm_fir_decimate_instance_q15 *S, uint16_t numTaps,
+                                     uint8_t M, q15_t *pCoeffs, q15_t *pState, uint32_t blockSize)
+{
+    if (M == 0U || blockSize % M != 0U) {
+        return ARM_MATH_LENGTH_ERROR;
+    }
+    S->M       = M;
+    S->numTaps = numTaps;
+    S->pCoeffs = pCoeffs;
+    S->pState  = pState;
+    memset(pState, 0, (numTaps + blockSize - 1U) * sizeof(q15_t));
+    return ARM_MATH_SUCCESS;
+}
+
+/* Coefficients in time-reversed order, the state oldest sample first */
+void arm_fir_decimate_fast_q15(const arm_fir_decimate_instance_q15 *S,
+                               q15_t *pSrc, q15_t *pDst, uint32_t blockSize)
+{
+    q15_t *st = S->pState;
+    uint32_t taps = S->numTaps, i, k;
+    int32_t acc;
+
+    memcpy(&st[taps - 1U], pSrc, blockSize * sizeof(q15_t));
+    for (i = 0; i < blockSize / S->M; i++) {
+        acc = 0;
+        for (k = 0; k < taps; k++) {
+            acc += S->pCoeffs[k] * st[i * S->M + k];
+        }
+        pDst[i] = clip_q31_to_q15(acc >> 15);
+    }
+    memmove(st, &st[blockSize], (taps - 1U) * sizeof(q15_t));
+}
@@ -0,0 +1,32 @@
+/**
+  ******************************************************************************
+  * @file    sim_isr.c
+  * @brief   Interrupt entry and exit for simulated peripherals.
+  *          The ThreadX Linux port models an interrupt as a host thread
+  *          bracketed by context save/restore: save suspends whichever
+  *          ThreadX thread is running, restore lets the scheduler pick the
+  *          next one, so ISR callbacks see the same preemption as on target.
+  *          Not yet run on the port itself; see Host/CMakeLists.txt.
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include "sim.h"
+#include "prof.h"
+
+/* Private function prototypes -----------------------------------------------*/
+/* tx_thread.h is internal to ThreadX */
+VOID _tx_thread_context_save(VOID);
+VOID _tx_thread_context_restore(VOID);
+
+void SIM_IsrEnter(void)
+{
+    _tx_thread_context_save();
+    sim_stats.irqs++;
+    PROF_ISR_ENTER();
+}
+
+void SIM_IsrExit(void)
+{
+    PROF_ISR_EXIT();
+    _tx_thread_context_restore();
+}
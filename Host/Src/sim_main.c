@@ -0,0 +1,414 @@
+/**
+  ******************************************************************************
+  * @file    sim_main.c
+  * @brief   Host simulator entry point.
+  *          Stands in for main.c and the CubeMX init code: it owns the
+  *          peripheral handles, parses the command line and enters ThreadX,
+  *          whose Linux port then calls the unmodified tx_application_define.
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#include <getopt.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "sim.h"
+#include "main.h"
+#include "adc.h"
+#include "crc.h"
+#include "spi.h"
+#include "tim.h"
+#include "usart.h"
+#include "acq.h"
+#include "defer.h"
+#include "display.h"
+#include "lowpower.h"
+#include "modbus.h"
+#include "prof.h"
+
+/* Private variables ---------------------------------------------------------*/
+SIM_PeriphTypeDef sim_adc1   = {"ADC1"};
+SIM_PeriphTypeDef sim_crc    = {"CRC"};
+SIM_PeriphTypeDef sim_gpioa  = {"GPIOA"};
+SIM_PeriphTypeDef sim_gpiob  = {"GPIOB"};
+SIM_PeriphTypeDef sim_gpioc  = {"GPIOC"};
+SIM_PeriphTypeDef sim_spi1   = {"SPI1"};
+SIM_PeriphTypeDef sim_tim1   = {"TIM1"};
+SIM_PeriphTypeDef sim_tim2   = {"TIM2"};
+SIM_PeriphTypeDef sim_tim3   = {"TIM3"};
+SIM_PeriphTypeDef sim_usart1 = {"USART1"};
+SIM_PeriphTypeDef sim_usart2 = {"USART2"};
+
+static SIM_PeriphTypeDef sim_dma_ch1 = {"DMA1_Channel1"};
+static SIM_PeriphTypeDef sim_dma_ch2 = {"DMA1_Channel2"};
+static SIM_PeriphTypeDef sim_dma_ch3 = {"DMA1_Channel3"};
+static SIM_PeriphTypeDef sim_dma_ch4 = {"DMA1_Channel4"};
+static SIM_PeriphTypeDef sim_dma_ch5 = {"DMA1_Channel5"};
+
+static DMA_HandleTypeDef hdma_adc1       = {&sim_dma_ch1};
+static DMA_HandleTypeDef hdma_usart1_tx  = {&sim_dma_ch2};
+static DMA_HandleTypeDef hdma_usart2_tx  = {&sim_dma_ch3};
+static DMA_HandleTypeDef hdma_usart2_rx  = {&sim_dma_ch4};
+static DMA_HandleTypeDef hdma_spi1_tx    = {&sim_dma_ch5};
+
+ADC_HandleTypeDef hadc1   = {ADC1, {DISABLE, {0}}, &hdma_adc1, 0};
+SPI_HandleTypeDef hspi1   = {SPI1, {SPI_DATASIZE_8BIT}, &hdma_spi1_tx};
+/* Same time bases as MX_TIM1_Init and MX_TIM2_Init: 1 MHz counters,
+   1 kHz update and free-running */
+TIM_HandleTypeDef htim1   = {TIM1, {64U - 1U, 1000U - 1U}, 0, 0, 0};
+TIM_HandleTypeDef htim2   = {TIM2, {64U - 1U, 0xFFFFFFFFU}, 0, 0, 0};
+/* MX_TIM3_Init: free-running at 32 MHz */
+TIM_HandleTypeDef htim3   = {TIM3, {2U - 1U, 65535U}, 0, 0, 0};
+UART_HandleTypeDef huart1 = {USART1, {460800}, &hdma_usart1_tx, NULL, HAL_UART_STATE_READY};
+UART_HandleTypeDef huart2 = {USART2, {460800}, &hdma_usart2_tx, &hdma_usart2_rx, HAL_UART_STATE_READY};
+/* Same configuration as MX_CRC_Init: CRC-16/CCITT-FALSE */
+CRC_HandleTypeDef hcrc    = {CRC, {0x1021U, CRC_POLYLENGTH_16B, 0xFFFFU}};
+
+SIM_ConfigTypeDef sim_config = {NULL, 1.0, 0.0, 1};
+SIM_StatsTypeDef sim_stats;
+
+/* From usart.c USER CODE 1 */
+static uint8_t stdout_tx_buf[UART_TX_STDOUT_SIZE];
+UART_TX_HandleTypeDef uart_tx_stdout;
+
+static double sim_start;
+
+static pthread_t sim_tim_thread;
+static pthread_mutex_t sim_tim_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sim_tim_change;
+/* Set by a new compare value or interrupt enable, cleared by the match */
+static int sim_tim_armed;
+
+/* Private function prototypes -----------------------------------------------*/
+static void SIM_Report(void);
+static void *SIM_Watchdog(void *arg);
+static void SIM_TIM_Init(void);
+static void *SIM_TIM_Thread(void *arg);
+static void SIM_Usage(const char *prog);
+
+UINT USART_Stdout_Init(void)
+{
+    return UART_TX_Init(&uart_tx_stdout, &STDOUT_UART, stdout_tx_buf, sizeof(stdout_tx_buf));
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    UART_TX_ErrorCallback(huart);
+#if (USE_MODBUS)
+    MODBUS_ErrorCallback(huart);
+#endif
+}
+
+void Error_Handler(void)
+{
+    fprintf(stderr, "sim: Error_Handler\n");
+    abort();
+}
+
+uint32_t HAL_GetTick(void)
+{
+    return (uint32_t)tx_time_get();
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef *htim)
+{
+    (void)htim;
+    return HAL_OK;
+}
+
+uint32_t SIM_TIM_GetCounter(const TIM_HandleTypeDef *htim)
+{
+    double now = SIM_Now(), counts;
+
+    if (htim->Instance == TIM1) {
+        counts = (now - sim_adc_trigger) * sim_config.rate * 64e6 / (htim->Init.Prescaler + 1U);
+        return (counts < htim->Init.Period) ? (uint32_t)counts : htim->Init.Period;
+    }
+    counts = (now - sim_start) * 64e6 / (htim->Init.Prescaler + 1U);
+    if (htim->Instance == TIM2) {
+        counts *= sim_config.rate;
+    }
+    return (uint32_t)((uint64_t)counts % ((uint64_t)htim->Init.Period + 1U));
+}
+
+void SIM_TIM_SetCompare(TIM_HandleTypeDef *htim, uint32_t compare)
+{
+    pthread_mutex_lock(&sim_tim_lock);
+    htim->ccr2    = compare;
+    sim_tim_armed = (htim == &htim2);
+    pthread_cond_signal(&sim_tim_change);
+    pthread_mutex_unlock(&sim_tim_lock);
+}
+
+void SIM_TIM_EnableIT(TIM_HandleTypeDef *htim, uint32_t it)
+{
+    pthread_mutex_lock(&sim_tim_lock);
+    htim->dier   |= it;
+    sim_tim_armed = (htim == &htim2);
+    pthread_cond_signal(&sim_tim_change);
+    pthread_mutex_unlock(&sim_tim_lock);
+}
+
+/* The host never sleeps, holds have nothing to keep awake */
+void LP_Hold(void)
+{
+}
+
+void LP_Release(void)
+{
+}
+
+/* The core clock as the firmware counts it, from the host clock */
+uint32_t LP_Cycles(void)
+{
+    return (uint32_t)(uint64_t)((SIM_Now() - sim_start) * 64e6);
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+    (void)GPIOx;
+    (void)GPIO_Pin;
+    (void)PinState;
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    (void)GPIOx;
+    (void)GPIO_Pin;
+}
+
+/* SPI1 only feeds the display: transfers are counted, not drawn, and
+   complete at once */
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef *hspi)
+{
+    (void)hspi;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    (void)pData;
+    (void)Timeout;
+    sim_stats.spi_bytes += (hspi->Init.DataSize == SPI_DATASIZE_16BIT) ? 2U * Size : Size;
+    return HAL_OK;
+}
+
+#if (USE_DISPLAY)
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size)
+{
+    HAL_SPI_Transmit(hspi, pData, Size, 0);
+    SIM_IsrEnter();
+    HAL_SPI_TxCpltCallback(hspi);
+    SIM_IsrExit();
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Abort(SPI_HandleTypeDef *hspi)
+{
+    (void)hspi;
+    return HAL_OK;
+}
+#endif /* USE_DISPLAY */
+
+/**
+  * @brief  Bit-serial model of the CRC unit, MSB first, no reflection.
+  * @param  hcrc : CRC handle, only Init is used
+  * @param  pBuffer : bytes, as with CRC_INPUTDATA_FORMAT_BYTES
+  * @param  BufferLength : number of bytes
+  * @retval CRC value
+  */
+uint32_t HAL_CRC_Calculate(CRC_HandleTypeDef *hcrc, uint32_t pBuffer[], uint32_t BufferLength)
+{
+    const uint8_t *p = (const uint8_t *)pBuffer;
+    uint16_t crc     = (uint16_t)hcrc->Init.InitValue;
+    uint16_t poly    = (uint16_t)hcrc->Init.GeneratingPolynomial;
+    uint32_t i, b;
+
+    for (i = 0; i < BufferLength; i++) {
+        crc ^= (uint16_t)(p[i] << 8);
+        for (b = 0; b < 8U; b++) {
+            crc = (crc & 0x8000U) ? (uint16_t)((crc << 1) ^ poly) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/**
+  * @brief  Run the application against simulated peripherals.
+  * @retval Does not return
+  */
+int main(int argc, char *argv[])
+{
+    pthread_t watchdog;
+    sigset_t stop;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "i:r:t:nh")) != -1) {
+        switch (opt) {
+        case 'i':
+            sim_config.input = optarg;
+            break;
+        case 'r':
+            sim_config.rate = atof(optarg);
+            break;
+        case 't':
+            sim_config.seconds = atof(optarg);
+            break;
+        case 'n':
+            sim_config.wire_time = 0;
+            break;
+        default:
+            SIM_Usage(argv[0]);
+            return 2;
+        }
+    }
+    if (sim_config.rate <= 0.0) {
+        SIM_Usage(argv[0]);
+        return 2;
+    }
+
+    setvbuf(stdout, NULL, _IONBF, 0);
+    SIM_UART_Init();
+    SIM_TIM_Init();
+
+    /* Ctrl-C and the -t limit both end up in SIM_Watchdog; every thread
+       created from here on, ThreadX ones included, inherits the mask */
+    sigemptyset(&stop);
+    sigaddset(&stop, SIGINT);
+    sigaddset(&stop, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop, NULL);
+    sim_start = SIM_Now();
+    pthread_create(&watchdog, NULL, SIM_Watchdog, NULL);
+#ifdef TX_EXECUTION_PROFILE_ENABLE
+    PROF_Init();
+#endif
+
+    /* Enter ThreadX; tx_application_define in app_azure_rtos.c does the rest */
+    tx_kernel_enter();
+    return 0;
+}
+
+double SIM_Now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+void SIM_Sleep(double seconds)
+{
+    struct timespec ts;
+
+    if (seconds <= 0.0) {
+        return;
+    }
+    ts.tv_sec  = (time_t)seconds;
+    ts.tv_nsec = (long)((seconds - (double)ts.tv_sec) * 1e9);
+    while (nanosleep(&ts, &ts) != 0) {
+    }
+}
+
+static void SIM_Report(void)
+{
+    double elapsed = SIM_Now() - sim_start;
+
+    fprintf(stderr,
+            "sim: %.2f s, %llu frames (%.0f/s), %llu irqs\n"
+            "sim: uart1 %llu B, uart2 %llu B (%.0f B/s)\n"
+            "sim: acq_overruns %lu, defer_dropped %lu, stdout dropped %lu\n",
+            elapsed, (unsigned long long)sim_stats.frames, (double)sim_stats.frames / elapsed,
+            (unsigned long long)sim_stats.irqs, (unsigned long long)sim_stats.uart_bytes[0],
+            (unsigned long long)sim_stats.uart_bytes[1],
+            (double)(sim_stats.uart_bytes[0] + sim_stats.uart_bytes[1]) / elapsed,
+            (unsigned long)acq_overruns, (unsigned long)defer_dropped, (unsigned long)uart_tx_stdout.dropped);
+#if (USE_DISPLAY)
+    fprintf(stderr, "sim: display %lu frames, spi1 %llu B\n",
+            (unsigned long)disp_frames, (unsigned long long)sim_stats.spi_bytes);
+#endif
+}
+
+static void *SIM_Watchdog(void *arg)
+{
+    struct timespec limit;
+    sigset_t stop;
+
+    (void)arg;
+    sigemptyset(&stop);
+    sigaddset(&stop, SIGINT);
+    sigaddset(&stop, SIGTERM);
+    if (sim_config.seconds > 0.0) {
+        limit.tv_sec  = (time_t)sim_config.seconds;
+        limit.tv_nsec = (long)((sim_config.seconds - (double)limit.tv_sec) * 1e9);
+        sigtimedwait(&stop, NULL, &limit);
+    } else {
+        sigwaitinfo(&stop, NULL);
+    }
+    SIM_Report();
+    exit(0);
+    return NULL;
+}
+
+static void SIM_TIM_Init(void)
+{
+    pthread_condattr_t attr;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&sim_tim_change, &attr);
+    pthread_create(&sim_tim_thread, NULL, SIM_TIM_Thread, NULL);
+}
+
+/* TIM2 channel 2: raise the interrupt once the count reaches CCR2 */
+static void *SIM_TIM_Thread(void *arg)
+{
+    struct timespec until;
+    double wait;
+
+    (void)arg;
+    pthread_mutex_lock(&sim_tim_lock);
+    for (;;) {
+        if (!sim_tim_armed || (htim2.dier & TIM_IT_CC2) == 0U) {
+            pthread_cond_wait(&sim_tim_change, &sim_tim_lock);
+            continue;
+        }
+        wait = (double)(int32_t)(htim2.ccr2 - SIM_TIM_GetCounter(&htim2)) *
+               (htim2.Init.Prescaler + 1U) / (64e6 * sim_config.rate);
+        if (wait > 0.0) {
+            clock_gettime(CLOCK_MONOTONIC, &until);
+            until.tv_sec  += (time_t)wait;
+            until.tv_nsec += (long)((wait - (double)(time_t)wait) * 1e9);
+            if (until.tv_nsec >= 1000000000L) {
+                until.tv_nsec -= 1000000000L;
+                until.tv_sec++;
+            }
+            pthread_cond_timedwait(&sim_tim_change, &sim_tim_lock, &until);
+            continue;
+        }
+        sim_tim_armed = 0;
+        htim2.sr |= TIM_FLAG_CC2;
+        pthread_mutex_unlock(&sim_tim_lock);
+
+        /* The USER CODE part of TIM2_IRQHandler in stm32g0xx_it.c */
+        SIM_IsrEnter();
+#if (USE_MODBUS)
+        MODBUS_TIM_IRQHandler(&htim2);
+#endif
+        SIM_IsrExit();
+        pthread_mutex_lock(&sim_tim_lock);
+    }
+    return NULL;
+}
+
+static void SIM_Usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [-i samples.csv] [-r rate] [-t seconds] [-n]\n"
+            "  -i  replay x,y,z[,vref] ADC codes from a CSV file, looping\n"
+            "  -r  run TIM1 this many times faster than 1 kHz\n"
+            "  -t  print statistics and exit after this many seconds\n"
+            "  -n  do not hold UART transfers for their time on the wire\n",
+            prog);
+}
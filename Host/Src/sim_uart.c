@@ -0,0 +1,323 @@
+/**
+  ******************************************************************************
+  * @file    sim_uart.c
+  * @brief   USART1/USART2 with TX and RX DMA, simulated on pseudo-terminals.
+  *          Each UART gets a pty in raw mode; point a terminal or
+  *          Tools/stream_parser.py at the printed /dev/pts path. A transfer
+  *          is handed to a per-port pthread that writes it to the pty, holds
+  *          it for its time on the wire at the configured baud rate and then
+  *          raises the transfer-complete interrupt. Nothing reading the pty
+  *          back-pressures the application exactly as a stalled link would.
+  *          A second pthread per port copies what is written to the pty into
+  *          the circular RX DMA buffer and raises the idle-line interrupt
+  *          once the line has been quiet for a character.
+  ******************************************************************************
+  */
+/* Includes ------------------------------------------------------------------*/
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+#include "sim.h"
+#include "usart.h"
+#include "modbus.h"
+
+/* Private define ------------------------------------------------------------*/
+#define SIM_UART_PORTS 2U
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct {
+    UART_HandleTypeDef *huart;
+    int master;
+    int slave; /* kept open so writes buffer while nobody is attached */
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    const uint8_t *data;
+    uint16_t size;
+    volatile uint64_t *bytes;
+    pthread_t rx_thread;
+    uint8_t *rx_data;       /* circular RX DMA buffer, NULL until reception starts */
+    uint16_t rx_size;
+    volatile uint16_t rx_left; /* the channel's CNDTR */
+    volatile uint32_t isr;  /* USART_ISR flags */
+} SIM_UART_PortTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+static SIM_UART_PortTypeDef sim_uart_ports[SIM_UART_PORTS];
+
+/* Private function prototypes -----------------------------------------------*/
+static void SIM_UART_Open(SIM_UART_PortTypeDef *port, UART_HandleTypeDef *huart, volatile uint64_t *bytes);
+static SIM_UART_PortTypeDef *SIM_UART_Port(const UART_HandleTypeDef *huart);
+static void SIM_UART_Write(SIM_UART_PortTypeDef *port, const uint8_t *data, uint16_t size);
+static void *SIM_UART_Thread(void *arg);
+static void *SIM_UART_RxThread(void *arg);
+static void SIM_UART_IRQHandler(UART_HandleTypeDef *huart);
+
+/**
+  * @brief  Create the ptys and the DMA threads. Called from main.
+  * @retval None
+  */
+void SIM_UART_Init(void)
+{
+    SIM_UART_Open(&sim_uart_ports[0], &huart1, &sim_stats.uart_bytes[0]);
+    SIM_UART_Open(&sim_uart_ports[1], &huart2, &sim_stats.uart_bytes[1]);
+}
+
+/**
+  * @brief  Blocking transmit, for code that bypasses the DMA engine.
+  */
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    SIM_UART_PortTypeDef *port = SIM_UART_Port(huart);
+
+    (void)Timeout;
+    if (port == NULL) {
+        return HAL_ERROR;
+    }
+    if (huart->gState != HAL_UART_STATE_READY) {
+        return HAL_BUSY;
+    }
+    SIM_UART_Write(port, pData, Size);
+    return HAL_OK;
+}
+
+/**
+  * @brief  Start a DMA transfer; completion arrives as HAL_UART_TxCpltCallback.
+  */
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size)
+{
+    SIM_UART_PortTypeDef *port = SIM_UART_Port(huart);
+
+    if (port == NULL || Size == 0U) {
+        return HAL_ERROR;
+    }
+    pthread_mutex_lock(&port->lock);
+    if (huart->gState != HAL_UART_STATE_READY) {
+        pthread_mutex_unlock(&port->lock);
+        return HAL_BUSY;
+    }
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+    port->data    = pData;
+    port->size    = Size;
+    pthread_cond_signal(&port->start);
+    pthread_mutex_unlock(&port->lock);
+    return HAL_OK;
+}
+
+/**
+  * @brief  A transfer handed to the port thread cannot be called back;
+  *         only the handle is made ready again.
+  */
+HAL_StatusTypeDef HAL_UART_AbortTransmit(UART_HandleTypeDef *huart)
+{
+    SIM_UART_PortTypeDef *port = SIM_UART_Port(huart);
+
+    if (port == NULL) {
+        return HAL_ERROR;
+    }
+    pthread_mutex_lock(&port->lock);
+    port->size    = 0;
+    huart->gState = HAL_UART_STATE_READY;
+    pthread_mutex_unlock(&port->lock);
+    return HAL_OK;
+}
+
+/**
+  * @brief  Start circular reception; the buffer wraps like a DMA_CIRCULAR channel.
+  */
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+    SIM_UART_PortTypeDef *port = SIM_UART_Port(huart);
+
+    if (port == NULL || huart->hdmarx == NULL || Size == 0U) {
+        return HAL_ERROR;
+    }
+    pthread_mutex_lock(&port->lock);
+    port->rx_data = pData;
+    port->rx_size = Size;
+    port->rx_left = Size;
+    pthread_mutex_unlock(&port->lock);
+    return HAL_OK;
+}
+
+uint32_t SIM_DMA_GetCounter(const DMA_HandleTypeDef *hdma)
+{
+    uint32_t i;
+
+    for (i = 0; i < SIM_UART_PORTS; i++) {
+        if (sim_uart_ports[i].huart->hdmarx == hdma) {
+            return sim_uart_ports[i].rx_left;
+        }
+    }
+    return 0;
+}
+
+FlagStatus SIM_UART_GetFlag(const UART_HandleTypeDef *huart, uint32_t flag)
+{
+    SIM_UART_PortTypeDef *port = SIM_UART_Port(huart);
+
+    return (port != NULL && (port->isr & flag) == flag) ? SET : RESET;
+}
+
+void SIM_UART_ClearFlag(const UART_HandleTypeDef *huart, uint32_t flag)
+{
+    SIM_UART_PortTypeDef *port = SIM_UART_Port(huart);
+
+    if (port != NULL) {
+        port->isr &= ~flag;
+    }
+}
+
+static void SIM_UART_Open(SIM_UART_PortTypeDef *port, UART_HandleTypeDef *huart, volatile uint64_t *bytes)
+{
+    struct termios tio;
+
+    port->huart  = huart;
+    port->bytes  = bytes;
+    port->master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (port->master < 0 || grantpt(port->master) != 0 || unlockpt(port->master) != 0) {
+        perror("sim: posix_openpt");
+        exit(1);
+    }
+    port->slave = open(ptsname(port->master), O_RDWR | O_NOCTTY);
+    if (port->slave < 0 || tcgetattr(port->slave, &tio) != 0) {
+        perror("sim: pty slave");
+        exit(1);
+    }
+    cfmakeraw(&tio);
+    tcsetattr(port->slave, TCSANOW, &tio);
+
+    pthread_mutex_init(&port->lock, NULL);
+    pthread_cond_init(&port->start, NULL);
+    pthread_create(&port->thread, NULL, SIM_UART_Thread, port);
+    pthread_create(&port->rx_thread, NULL, SIM_UART_RxThread, port);
+    fprintf(stderr, "sim: %s on %s\n", huart->Instance->name, ptsname(port->master));
+}
+
+static SIM_UART_PortTypeDef *SIM_UART_Port(const UART_HandleTypeDef *huart)
+{
+    uint32_t i;
+
+    for (i = 0; i < SIM_UART_PORTS; i++) {
+        if (sim_uart_ports[i].huart == huart) {
+            return &sim_uart_ports[i];
+        }
+    }
+    return NULL;
+}
+
+static void SIM_UART_Write(SIM_UART_PortTypeDef *port, const uint8_t *data, uint16_t size)
+{
+    ssize_t n;
+
+    while (size != 0U) {
+        n = write(port->master, data, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("sim: pty write");
+            exit(1);
+        }
+        data += n;
+        size  = (uint16_t)(size - n);
+        *port->bytes += (uint64_t)n;
+    }
+}
+
+/* The DMA channel: move one transfer, then interrupt */
+static void *SIM_UART_Thread(void *arg)
+{
+    SIM_UART_PortTypeDef *port = arg;
+    const uint8_t *data;
+    uint16_t size;
+
+    for (;;) {
+        pthread_mutex_lock(&port->lock);
+        while (port->size == 0U) {
+            pthread_cond_wait(&port->start, &port->lock);
+        }
+        data       = port->data;
+        size       = port->size;
+        port->size = 0;
+        pthread_mutex_unlock(&port->lock);
+
+        SIM_UART_Write(port, data, size);
+        if (sim_config.wire_time) {
+            /* 8N1: ten bit times per byte */
+            SIM_Sleep(10.0 * size / (double)port->huart->Init.BaudRate);
+        }
+
+        SIM_IsrEnter();
+        port->isr |= USART_ISR_TC;
+        SIM_UART_IRQHandler(port->huart);
+        port->huart->gState = HAL_UART_STATE_READY;
+        HAL_UART_TxCpltCallback(port->huart);
+        SIM_UART_ClearFlag(port->huart, USART_ISR_TC);
+        SIM_IsrExit();
+    }
+    return NULL;
+}
+
+/* The RX DMA channel and the idle line */
+static void *SIM_UART_RxThread(void *arg)
+{
+    SIM_UART_PortTypeDef *port = arg;
+    struct pollfd pfd = {port->master, POLLIN, 0};
+    struct timespec quiet;
+    uint8_t chunk[64];
+    uint16_t pos;
+    int received = 0;
+    ssize_t n, i;
+
+    for (;;) {
+        /* 8N1: an idle character is ten bit times */
+        quiet.tv_sec  = 0;
+        quiet.tv_nsec = (long)(10.0 * 1e9 / (double)port->huart->Init.BaudRate);
+        if (ppoll(&pfd, 1, received ? &quiet : NULL, NULL) == 0) {
+            /* Silent for a character after the last one */
+            received = 0;
+            SIM_IsrEnter();
+            port->isr |= USART_ISR_IDLE;
+            SIM_UART_IRQHandler(port->huart);
+            SIM_IsrExit();
+            continue;
+        }
+        n = read(port->master, chunk, sizeof(chunk));
+        if (n <= 0) {
+            if (n < 0 && errno != EINTR && errno != EAGAIN) {
+                perror("sim: pty read");
+                exit(1);
+            }
+            continue;
+        }
+        pthread_mutex_lock(&port->lock);
+        if (port->rx_data != NULL) {
+            for (i = 0; i < n; i++) {
+                pos = (uint16_t)(port->rx_size - port->rx_left);
+                port->rx_data[pos] = chunk[i];
+                port->rx_left = (port->rx_left == 1U) ? port->rx_size : (uint16_t)(port->rx_left - 1U);
+            }
+            received = 1;
+        }
+        pthread_mutex_unlock(&port->lock);
+        if (sim_config.wire_time) {
+            SIM_Sleep(10.0 * (double)n / (double)port->huart->Init.BaudRate);
+        }
+    }
+    return NULL;
+}
+
+/* The USER CODE part of USART1_IRQHandler / USART2_IRQHandler in stm32g0xx_it.c */
+static void SIM_UART_IRQHandler(UART_HandleTypeDef *huart)
+{
+#if (USE_MODBUS)
+    MODBUS_UART_IRQHandler(huart);
+#endif
+    SIM_UART_ClearFlag(huart, USART_ISR_IDLE);
+}
@@ -39,7 +39,7 @@ __initial_sp
 ;   <o>  Heap Size (in Bytes) <0x0-0xFFFFFFFF:8>
 ; </h>
 
-Heap_Size      EQU     0x400
+Heap_Size      EQU     0x0
 
                 AREA    HEAP, NOINIT, READWRITE, ALIGN=3
 __heap_base
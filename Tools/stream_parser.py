@@ -0,0 +1,556 @@
+#!/usr/bin/env python3
+"""Host-side parser for the framed sample stream (see Core/Inc/stream.h).
+
+    stream_parser.py COM5             read a serial port at 460800 baud
+    stream_parser.py capture.bin      read a raw capture
+    stream_parser.py COM5 --csv out.csv
+    stream_parser.py COM5 --trace out.trx   also rebuild a TraceX file
+
+CSV rows are stamp,block,time,x,y,z: time is the trigger time of the frame
+in microseconds since the firmware started, taken from the packet header and
+the frame period, so lost packets do not shift later rows. Within a run the
+firmware measures it on a 1 MHz timer, to a microsecond either way; a
+restarted run is placed by the kernel tick. Any larger step against the frame
+count, from a restart or from frames lost to an ADC overrun, is reported on
+stderr.
+
+Packed samples (STREAM_FORMAT_PACKED) are unpacked to the same CSV columns,
+left empty for the axes not sent. Compressed samples (STREAM_FORMAT_RICE, see
+Core/Inc/rice.h) are decoded the same way and checked against the sums the
+firmware sends; the compression ratio and any mismatch are reported on exit.
+Calibrated samples (USE_CAL, see Core/Inc/cal.h) are in mg and
+conditioned samples (USE_COND, see Core/Inc/cond.h) are q15; both go to the
+CSV like raw ones, one row per output frame, and VDDA changes of more than
+VDDA_REPORT_MV are reported on stderr. Event records (USE_EVENT, see
+Core/Inc/event.h) go to the CSV with the block each frame was taken in, and
+every completed event is summarised on stderr, as is every statistics
+window (USE_STATS, see Core/Inc/stats.h). Spectrum packets
+(USE_SPECTRUM) are printed as bin:magnitude lists, metadata packets (sample rate, oversampling, resolution), execution
+profiles (CPU share per thread, interrupts and idle), stack reports (peak
+use of every stack) and latency histograms go to stderr. Event trace packets are collected
+and written as a TraceX file on exit with --trace.
+
+Resync rule: scan for the sync word, accept a packet only if the version is
+known, the length is in range and the CRC matches; otherwise skip one byte
+past the sync word and scan again. Gaps in the packet and block counters are
+reported on stderr.
+"""
+import argparse
+import struct
+import sys
+
+SYNC = b'\xa5\x5a'
+VERSION = 2
+HEADER_SIZE = 8
+CRC_SIZE = 2
+MAX_PAYLOAD = 1024
+
+TYPE_SAMPLES = 1
+TYPE_PEAKS = 2
+TYPE_BINS = 3
+TYPE_META = 4
+TYPE_PROFILE = 5
+TYPE_STACK = 6
+TYPE_TRACE = 7
+TYPE_LATENCY = 8
+TYPE_COND = 9
+TYPE_CAL = 10
+TYPE_EVENT = 11
+TYPE_STATS = 12
+TYPE_PACKED = 13
+TYPE_RICE = 14
+
+LATENCY_STAGES = ('trigger-irq', 'irq-thread', 'total')
+TRACE_KIND_IMAGE = 0
+TRACE_KIND_EVENTS = 1
+TRACE_ENTRY_SIZE = 32
+TRACE_ID = 0x54585442  # TX_TRACE_BUFFER_ID
+BLOCK_FRAMES = 16  # ACQ_BLOCK_FRAMES
+EVENT_FLAG_LAST = 0x01
+EVENT_FLAG_TRUNCATED = 0x02
+VDDA_REPORT_MV = 10
+# TIM2 less TIM1 read one after the other: block times move by a count either way
+TIME_JITTER_US = 1
+RICE_K_BITS = 5
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE, as configured in MX_CRC_Init."""
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+class Parser:
+    """Feed bytes in, get (type, seq, payload) tuples out."""
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.resyncs = 0
+
+    def feed(self, data):
+        self.buf += data
+        while True:
+            start = self.buf.find(SYNC)
+            if start < 0:
+                # keep a trailing 0xA5 that may be the first half of a sync word
+                del self.buf[:max(len(self.buf) - 1, 0)]
+                return
+            if start:
+                self.resyncs += 1
+                del self.buf[:start]
+            if len(self.buf) < HEADER_SIZE:
+                return
+            version, ptype, seq, length = struct.unpack_from('<BBHH', self.buf, 2)
+            if version != VERSION or length > MAX_PAYLOAD:
+                del self.buf[:1]
+                continue
+            end = HEADER_SIZE + length + CRC_SIZE
+            if len(self.buf) < end:
+                return
+            (crc,) = struct.unpack_from('<H', self.buf, end - CRC_SIZE)
+            if crc16(self.buf[2:end - CRC_SIZE]) != crc:
+                self.resyncs += 1
+                del self.buf[:1]
+                continue
+            payload = bytes(self.buf[HEADER_SIZE:end - CRC_SIZE])
+            del self.buf[:end]
+            yield ptype, seq, payload
+
+
+def decode_samples(payload):
+    """Return (stamp, block, time, [(x, y, z), ...]) from a samples payload."""
+    stamp, block, time, frames, channels = struct.unpack_from('<IIQBB', payload, 0)
+    values = struct.unpack_from('<%dH' % (frames * channels), payload, 18)
+    rows = [values[i:i + channels] for i in range(0, len(values), channels)]
+    return stamp, block, time, rows
+
+
+def unpack_bits(data, width, count):
+    """Return count width-bit samples from a little-endian bit stream."""
+    if width == 12:
+        # Two samples in three bytes: whole-buffer slices, no per-bit work
+        b0, b1, b2 = data[0::3], data[1::3], data[2::3]
+        values = [0] * (len(b2) * 2)
+        values[0::2] = [lo | (mid & 0x0F) << 8 for lo, mid in zip(b0, b1)]
+        values[1::2] = [mid >> 4 | hi << 4 for mid, hi in zip(b1, b2)]
+        return values[:count]
+    if width == 16:
+        return list(struct.unpack_from('<%dH' % count, data, 0))
+    bits = int.from_bytes(data, 'little')
+    mask = (1 << width) - 1
+    return [bits >> (i * width) & mask for i in range(count)]
+
+
+def decode_packed(payload):
+    """Return (stamp, block, time, [(x, y, z), ...]) from a packed payload, None for an axis not sent."""
+    stamp, block, time, frames, axes, width, channels = struct.unpack_from('<IIQBBBB', payload, 0)
+    values = unpack_bits(payload[20:], width, frames * channels)
+    sent = [axis for axis in range(3) if axes >> axis & 1]
+    rows = []
+    for i in range(0, len(values), channels):
+        row = [None, None, None]
+        for axis, v in zip(sent, values[i:i + channels]):
+            row[axis] = v
+        rows.append(tuple(row))
+    return stamp, block, time, rows
+
+
+class BitReader:
+    """Little-endian bit stream reader, bit 0 of a field first."""
+
+    def __init__(self, data):
+        self.bits = int.from_bytes(data, 'little')
+        self.pos = 0
+        self.end = len(data) * 8
+
+    def read(self, n):
+        v = self.bits >> self.pos & ((1 << n) - 1)
+        self.pos += n
+        if self.pos > self.end:
+            raise ValueError('bit stream overrun')
+        return v
+
+    def unary(self):
+        """Return the number of one bits before the next zero bit."""
+        rest = ~self.bits >> self.pos
+        if not rest or self.pos >= self.end:
+            raise ValueError('bit stream overrun')
+        q = (rest & -rest).bit_length() - 1
+        self.pos += q + 1
+        return q
+
+    def align(self):
+        self.pos = (self.pos + 7) & ~7
+
+
+def rice_predict(order, hist):
+    """Fixed predictor of rice.h from hist, most recent sample first."""
+    if order == 1:
+        return hist[0]
+    if order == 2:
+        return 2 * hist[0] - hist[1]
+    return 3 * (hist[0] - hist[1]) + hist[2]
+
+
+def decode_rice(payload):
+    """Return (stamp, block, time, [(x, y, z), ...], check ok) from a compressed payload."""
+    stamp, block, time, frames, axes, width, channels, sum1, sum2 = struct.unpack_from('<IIQBBBBHH', payload, 0)
+    sent = [axis for axis in range(3) if axes >> axis & 1]
+    reader = BitReader(payload[24:])
+    hist = {axis: [] for axis in sent}
+    rows = [[None, None, None] for _ in range(frames)]
+    s1 = s2 = 0
+    for first in range(0, frames, BLOCK_FRAMES):
+        for axis in sent:
+            h = hist[axis]
+            order = reader.read(2)
+            k = reader.read(RICE_K_BITS) if order else 0
+            for i in range(first, first + BLOCK_FRAMES):
+                if len(h) < order or not order:
+                    x = reader.read(width)
+                else:
+                    u = reader.unary() << k | reader.read(k)
+                    x = rice_predict(order, h) + (u >> 1 if not u & 1 else -(u >> 1) - 1)
+                rows[i][axis] = x
+                h.insert(0, x)
+                del h[3:]
+                s1 = (s1 + x) & 0xFFFF
+                s2 = (s2 + s1) & 0xFFFF
+        reader.align()
+    return stamp, block, time, [tuple(r) for r in rows], (s1, s2) == (sum1, sum2)
+
+
+def decode_cond(payload):
+    """Return (stamp, block, time, decimation, [(x, y, z), ...]) from a conditioned payload."""
+    stamp, block, time, frames, decimation = struct.unpack_from('<IIQBB', payload, 0)
+    values = struct.unpack_from('<%dh' % (frames * 3), payload, 18)
+    rows = [values[i:i + 3] for i in range(0, len(values), 3)]
+    return stamp, block, time, decimation, rows
+
+
+def decode_cal(payload):
+    """Return (stamp, block, time, vdda_mv, [(x, y, z), ...]) from a calibrated payload."""
+    stamp, block, time, frames, channels, vdda = struct.unpack_from('<IIQBBH', payload, 0)
+    values = struct.unpack_from('<%dh' % (frames * channels), payload, 20)
+    rows = [values[i:i + channels] for i in range(0, len(values), channels)]
+    return stamp, block, time, vdda, rows
+
+
+def decode_event(payload):
+    """Return (header dict, [(x, y, z), ...]) from an event record payload."""
+    names = ('stamp', 'block', 'time', 'frame', 'axes', 'event', 'offset', 'frames', 'flags')
+    rec = dict(zip(names, struct.unpack_from('<IIQBBHhBB', payload, 0)))
+    values = struct.unpack_from('<%dH' % (rec['frames'] * 3), payload, 24)
+    rows = [values[i:i + 3] for i in range(0, len(values), 3)]
+    return rec, rows
+
+
+def decode_stats(payload):
+    """Return (header dict, [axis dict, ...]) from a statistics payload."""
+    names = ('stamp', 'block', 'period_us', 'frames', 'bits', 'axes')
+    win = dict(zip(names, struct.unpack_from('<IIIHBB', payload, 0)))
+    names = ('mean', 'rms', 'min', 'max', 'peak', 'crest', 'kurtosis')
+    axes = []
+    for i in range(win['axes']):
+        axis = dict(zip(names, struct.unpack_from('<II5H', payload, 16 + 18 * i)))
+        for k in ('mean', 'rms', 'crest', 'kurtosis'):
+            axis[k] /= 256.0
+        axes.append(axis)
+    return win, axes
+
+
+def decode_meta(payload):
+    """Return a dict of the sampling set-up in a metadata payload."""
+    names = ('stamp', 'block', 'period_us', 'ratio', 'shift', 'bits', 'channels', 'frames')
+    return dict(zip(names, struct.unpack_from('<IIIHBBBB', payload, 0)))
+
+
+def decode_profile(payload):
+    """Return a dict of the window totals and a list of per-thread dicts."""
+    names = ('stamp', 'window_us', 'isr_us', 'irqs', 'idle_us', 'threads')
+    prof = dict(zip(names, struct.unpack_from('<IIIIIB', payload, 0)))
+    threads = []
+    for i in range(prof['threads']):
+        run_us, resumes, name = struct.unpack_from('<II16s', payload, 21 + 24 * i)
+        threads.append({'name': name.split(b'\0', 1)[0].decode('ascii', 'replace'),
+                        'run_us': run_us, 'resumes': resumes})
+    return prof, threads
+
+
+def decode_stack(payload):
+    """Return a dict of one stack record."""
+    names = ('stamp', 'index', 'count', 'size', 'peak', 'overflow', 'name')
+    stack = dict(zip(names, struct.unpack_from('<IBBHHBx16s', payload, 0)))
+    stack['name'] = stack['name'].split(b'\0', 1)[0].decode('ascii', 'replace')
+    return stack
+
+
+def latency_bin_range(i):
+    """Return the lowest and highest us of histogram bin i (see latency.h)."""
+    if i < 8:
+        return i, i
+    octave = (i - 8) // 4 + 1
+    step = (i - 8) % 4 + 4
+    return step << octave, ((step + 1) << octave) - 1
+
+
+def decode_latency(payload):
+    """Return a dict of one stage's statistics and its list of bin counts."""
+    names = ('stamp', 'stage', 'bins', 'count', 'min', 'mean', 'max',
+             'p50', 'p90', 'p99', 'p999', 'period_us', 'conv_us')
+    lat = dict(zip(names, struct.unpack_from('<IBB2x10I', payload, 0)))
+    counts = list(struct.unpack_from('<%dH' % lat['bins'], payload, 48))
+    return lat, counts
+
+
+class TraceFile:
+    """Rebuild a TraceX file from event trace packets (see Core/Inc/trace.h).
+
+    TraceX reads a dump of the ThreadX trace area: header, object registry,
+    event ring. The file keeps the header and registry as last received and
+    puts every entry received, oldest first, in a ring sized to hold them
+    all, with the header pointers moved to match.
+    """
+    HEADER = '<IIIIHHIIIIIII'
+
+    def __init__(self):
+        self.image = bytearray()
+        self.entries = []
+        self.next = None
+        self.lost = 0
+
+    def feed(self, payload):
+        if payload[0] == TRACE_KIND_IMAGE:
+            (offset,) = struct.unpack_from('<H', payload, 2)
+            data = payload[4:]
+            if len(self.image) < offset + len(data):
+                self.image.extend(bytes(offset + len(data) - len(self.image)))
+            self.image[offset:offset + len(data)] = data
+        elif payload[0] == TRACE_KIND_EVENTS:
+            count = payload[1]
+            (index,) = struct.unpack_from('<I', payload, 4)
+            if self.next is not None and index != self.next:
+                self.lost += (index - self.next) & 0xFFFFFFFF
+            self.next = (index + count) & 0xFFFFFFFF
+            for k in range(count):
+                start = 8 + TRACE_ENTRY_SIZE * k
+                self.entries.append(payload[start:start + TRACE_ENTRY_SIZE])
+
+    def write(self, name):
+        """Write the file; False when no header has been received."""
+        if len(self.image) < struct.calcsize(self.HEADER):
+            return False
+        header = list(struct.unpack_from(self.HEADER, self.image, 0))
+        if header[0] != TRACE_ID:
+            return False
+        base, buf_start = header[2], header[7]
+        area = self.image[:buf_start - base]
+        if len(area) < buf_start - base:
+            return False
+        entries = self.entries or [bytes(TRACE_ENTRY_SIZE)]
+        header[8] = buf_start + TRACE_ENTRY_SIZE * len(entries)  # buffer end
+        header[9] = buf_start                                     # current, the oldest entry
+        struct.pack_into(self.HEADER, area, 0, *header)
+        with open(name, 'wb') as f:
+            f.write(area)
+            f.write(b''.join(entries))
+        return True
+
+
+def decode_spectrum(ptype, payload):
+    """Return (stamp, block, fft_len, {axis: [(bin, magnitude), ...]})."""
+    stamp, block, fft_len, count = struct.unpack_from('<IIHB', payload, 0)
+    axes = {}
+    if ptype == TYPE_PEAKS:
+        for axis in range(3):
+            axes[axis] = [struct.unpack_from('<BH', payload, 11 + 3 * (axis * count + k))
+                          for k in range(count)]
+    else:
+        axis, first = struct.unpack_from('<BB', payload, 11)
+        mags = struct.unpack_from('<%dH' % count, payload, 13)
+        axes[axis] = [(first + k, m) for k, m in enumerate(mags)]
+    return stamp, block, fft_len, axes
+
+
+def open_source(name):
+    try:
+        return open(name, 'rb')
+    except OSError:
+        import serial  # pyserial, only needed for a live port
+        return serial.Serial(name, 460800, timeout=1)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument('source', help='serial port or capture file')
+    ap.add_argument('--csv', help='write samples as stamp,block,time,x,y,z')
+    ap.add_argument('--trace', help='write the event trace as a TraceX file')
+    args = ap.parse_args()
+
+    src = open_source(args.source)
+    live = hasattr(src, 'baudrate')
+    out = open(args.csv, 'w') if args.csv else None
+    parser = Parser()
+    trace = TraceFile() if args.trace else None
+    next_seq = next_block = next_time = last_setup = last_decimation = last_vdda = None
+    period_us = 0
+    packets = 0
+    # Compressed packets: count, check mismatches, payload bytes, bytes packed
+    rice = [0, 0, 0, 0]
+    # First offset of the events still being received
+    events = {}
+
+    try:
+        while True:
+            data = src.read(4096)
+            if not data:
+                if live:
+                    continue
+                break
+            for ptype, seq, payload in parser.feed(data):
+                packets += 1
+                if next_seq is not None and seq != next_seq:
+                    print('packet gap: expected %d got %d' % (next_seq, seq), file=sys.stderr)
+                next_seq = (seq + 1) & 0xFFFF
+                if ptype == TYPE_META:
+                    meta = decode_meta(payload)
+                    setup = [v for k, v in sorted(meta.items()) if k not in ('stamp', 'block')]
+                    if setup == last_setup:
+                        continue
+                    last_setup = setup
+                    period_us = meta['period_us']
+                    next_time = None
+                    print('meta: block %(block)d, fs %(fs).2f Hz, oversampling x%(ratio)d >> %(shift)d, '
+                          '%(bits)d bits' % dict(meta, fs=1e6 / meta['period_us']), file=sys.stderr)
+                    continue
+                if ptype == TYPE_PROFILE:
+                    prof, threads = decode_profile(payload)
+                    window = max(prof['window_us'], 1)
+                    print('profile: %.1f ms, idle %.1f %%, interrupts %.1f %% (%d)'
+                          % (window / 1e3, 100.0 * prof['idle_us'] / window,
+                             100.0 * prof['isr_us'] / window, prof['irqs']), file=sys.stderr)
+                    for t in threads:
+                        print('profile:   %-16s %5.1f %%  %d switches'
+                              % (t['name'], 100.0 * t['run_us'] / window, t['resumes']), file=sys.stderr)
+                    continue
+                if ptype == TYPE_STACK:
+                    stack = decode_stack(payload)
+                    print('stack: %d/%d %-16s %4d of %4d bytes%s'
+                          % (stack['index'], stack['count'], stack['name'], stack['peak'], stack['size'],
+                             ', OVERFLOW' if stack['overflow'] else ''), file=sys.stderr)
+                    continue
+                if ptype == TYPE_LATENCY:
+                    lat, counts = decode_latency(payload)
+                    stage = LATENCY_STAGES[lat['stage']] if lat['stage'] < len(LATENCY_STAGES) else lat['stage']
+                    print('latency: %-11s %d blocks, min %d mean %d max %d us, p50 %d p90 %d p99 %d p99.9 %d us'
+                          % (stage, lat['count'], lat['min'], lat['mean'], lat['max'],
+                             lat['p50'], lat['p90'], lat['p99'], lat['p999']), file=sys.stderr)
+                    bins = ['%d-%d:%d' % (latency_bin_range(i) + (n,)) for i, n in enumerate(counts) if n]
+                    if bins:
+                        print('latency:   %s' % ' '.join(bins), file=sys.stderr)
+                    continue
+                if ptype == TYPE_TRACE:
+                    if trace:
+                        trace.feed(payload)
+                    continue
+                if ptype in (TYPE_PEAKS, TYPE_BINS):
+                    stamp, block, fft_len, axes = decode_spectrum(ptype, payload)
+                    for axis, bins in sorted(axes.items()):
+                        print('%d %s %s' % (stamp, 'xyz'[axis],
+                                            ' '.join('%d:%d' % b for b in bins)))
+                    continue
+                if ptype == TYPE_STATS:
+                    win, axes = decode_stats(payload)
+                    print('stats: block %d, %d frames, %d bits'
+                          % (win['block'], win['frames'], win['bits']), file=sys.stderr)
+                    for name, a in zip('xyz', axes):
+                        print('stats:   %s mean %.1f rms %.2f p2p %d peak %d crest %.2f kurtosis %.2f'
+                              % (name, a['mean'], a['rms'], a['max'] - a['min'], a['peak'],
+                                 a['crest'], a['kurtosis']), file=sys.stderr)
+                    continue
+                if ptype == TYPE_EVENT:
+                    rec, rows = decode_event(payload)
+                    first = rec['frame'] + rec['offset']
+                    if out:
+                        for i, row in enumerate(rows):
+                            block = (rec['block'] + (first + i) // BLOCK_FRAMES) & 0xFFFFFFFF
+                            out.write('%d,%d,%d,%s\n' % (rec['stamp'], block, rec['time'] + (first + i) * period_us,
+                                                        ','.join(map(str, row))))
+                    if rec['flags'] & EVENT_FLAG_LAST:
+                        print('event %d: block %d frame %d, axes %s, %d frames before, %d from the trigger%s'
+                              % (rec['event'], rec['block'], rec['frame'],
+                                 ''.join(a for i, a in enumerate('xyz') if rec['axes'] >> i & 1),
+                                 -events.get(rec['event'], rec['offset']),
+                                 rec['offset'] + rec['frames'],
+                                 ', truncated' if rec['flags'] & EVENT_FLAG_TRUNCATED else ''), file=sys.stderr)
+                        events.pop(rec['event'], None)
+                    else:
+                        events.setdefault(rec['event'], rec['offset'])
+                    # Samples are no longer continuous
+                    next_block = next_time = None
+                    continue
+                if ptype == TYPE_COND:
+                    stamp, block, time, decimation, rows = decode_cond(payload)
+                    if decimation != last_decimation:
+                        last_decimation = decimation
+                        print('cond: decimation %d' % decimation, file=sys.stderr)
+                elif ptype == TYPE_CAL:
+                    stamp, block, time, vdda, rows = decode_cal(payload)
+                    decimation = 1
+                    if last_vdda is None or abs(vdda - last_vdda) > VDDA_REPORT_MV:
+                        last_vdda = vdda
+                        print('cal: vdda %d mV' % vdda, file=sys.stderr)
+                elif ptype == TYPE_SAMPLES:
+                    stamp, block, time, rows = decode_samples(payload)
+                    decimation = 1
+                elif ptype == TYPE_PACKED:
+                    stamp, block, time, rows = decode_packed(payload)
+                    decimation = 1
+                elif ptype == TYPE_RICE:
+                    try:
+                        stamp, block, time, rows, ok = decode_rice(payload)
+                    except ValueError:
+                        stamp, block, time, rows, ok = 0, 0, 0, [], False
+                    decimation = 1
+                    rice[0] += 1
+                    if not ok:
+                        rice[1] += 1
+                        print('rice: block %d does not decode to the samples sent' % block, file=sys.stderr)
+                        next_block = next_time = None
+                        continue
+                    width, channels = payload[18], payload[19]
+                    rice[2] += len(payload) - 24
+                    rice[3] += (len(rows) * channels * width + 7) // 8
+                else:
+                    continue
+                if next_block is not None and block != next_block:
+                    print('block gap: expected %d got %d' % (next_block, block), file=sys.stderr)
+                elif next_time is not None and abs(time - next_time) > TIME_JITTER_US:
+                    print('time: block %d resumes %+d us after the frame count' % (block, time - next_time), file=sys.stderr)
+                next_block = (block + len(rows) * decimation // BLOCK_FRAMES) & 0xFFFFFFFF
+                step = decimation * period_us
+                next_time = time + len(rows) * step
+                if out:
+                    for i, row in enumerate(rows):
+                        out.write('%d,%d,%d,%s\n' % (stamp, block, time + i * step,
+                                                    ','.join('' if v is None else str(v) for v in row)))
+    except KeyboardInterrupt:
+        pass
+    print('%d packets, %d resyncs' % (packets, parser.resyncs), file=sys.stderr)
+    if rice[0]:
+        print('rice: %d packets, %d check errors, %.2f of the packed size'
+              % (rice[0], rice[1], rice[2] / max(rice[3], 1)), file=sys.stderr)
+    if trace:
+        if trace.write(args.trace):
+            print('trace: %d entries, %d lost, written to %s'
+                  % (len(trace.entries), trace.lost, args.trace), file=sys.stderr)
+        else:
+            print('trace: no trace header received', file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()